@@ -23,8 +23,8 @@
  *     - <c> <b> WEMOS D1 mini ESP32 <\b></c>   (optional) \n
  *  \b Libs: \n
  *     - <c> ESP8266WiFi              Version 1.0     path: ~/.arduino15/packages/esp8266/hardware/esp8266/3.1.2/libraries/ESP8266WiFi </c>
- *     - <c> ESP8266WebServer         Version 1.0     path: ~/.arduino15/packages/esp8266/hardware/esp8266/3.1.2/libraries/ESP8266WebServer </c>
- *     - <c> ESP8266HTTPUpdateServer  Version 1.0     path: ~/.arduino15/packages/esp8266/hardware/esp8266/3.1.2/libraries/ESP8266HTTPUpdateServer </c>
+ *     - <c> ESPAsyncTCP              Version 1.2.2   path: ~/Arduino/libraries/ESPAsyncTCP </c>
+ *     - <c> ESPAsyncWebServer        Version 1.2.3   path: ~/Arduino/libraries/ESPAsyncWebServer </c>
  *     - <c> PubSubClient             Version 2.8     path: ~/Arduino/libraries/PubSubClient </c>
  *     - <c> ArduinoJson              Version 6.21.4  path: ~/Arduino/libraries/ArduinoJson </c>
  *     - <c> LittleFS                 Version 0.1.0   path: ~/.arduino15/packages/esp8266/hardware/esp8266/3.1.2/libraries/LittleFS </c>
@@ -38,6 +38,62 @@
  *  Doxygen:    https://www.doxygen.nl/manual/docblocks.html \n
  * 
  * Change Log:
+ * 2026-10-16 v0.9
+ * - cmd2pic() replaced by an asynchronous PIC transport (pic.ino): commands are submitted by
+ *   pic_submit(), the response is assembled by pic_poll() from loop() and passed to a completion 
+ *   callback. loop() never waits for the PIC and no longer calls server.handleClient() nested.
+ *   The blocking cmd2pic() remains for bulk transfers (firmware download, log data) only.
+ * - Binary framed protocol with CRC (sync, type, length, payload, CRC-16): negotiated by "Frame?"
+ *   at startup, the cyclic status is then requested and received as binary frame. 
+ *   PIC firmware without frame support answers with an error and the ASCII protocol is used.
+ * - struct FLAGS replaced by a command queue (cmdq.ino): move, home, version, logdata and bootload
+ *   requests are queued and sent in FIFO order, each with its own id and state (see <IP>/queue).
+ *   Requests for different zones within one status cycle no longer overwrite each other.
+ * - Fixed macros MOVE(x) and HOME(x) (missing parenthesis).
+ * - loop() runs a cooperative deadline scheduler (sched.ino). The former loop sections are jobs with
+ *   their own period and deadline: link (PIC transport and command queue), http, status request, 
+ *   display, sensor and mqtt. Overruns and idle time are reported by <IP>/sched.
+ * - Adaptive status polling: every POLL_FAST ms while a zone is in process (MOVE, HOME or VZ bits
+ *   of the PIC status), every POLL_IDLE ms at rest (both configurable in ovc.ini).
+ * - Unsolicited status frames: with frame protocol version 2 the PIC pushes its status on every
+ *   change and as heartbeat (10 s). pic_poll() receives them also between command responses.
+ *   The status is then requested every PUSH_WATCHDOG ms only; if the heartbeat fails, the frame 
+ *   protocol is negotiated again.
+ * - Versioned status snapshot (status.ino): the JSON status is serialized once per change and
+ *   served from a cache with ETag (HTTP 304 if unchanged), <IP>/status?since=<version> returns the
+ *   changed fields only. Removed duplicate VZ1 block in create_jStatus(), added "version".
+ * - Status push to the Web UI by Server-Sent Events (events.ino, <IP>/events): job 'events' sends
+ *   the changed fields to all subscribers as soon as the status has changed. index.html uses
+ *   EventSource and falls back to polling only if the browser doesn't support it.
+ * - Replaced ESP8266WebServer by the event driven ESPAsyncWebServer: the request handlers run in
+ *   the TCP callbacks, concurrently to loop(), static files are sent in chunks (AsyncFileResponse).
+ *   Slow clients, file downloads, firmware download or log data no longer block each other or the
+ *   PIC link. Job 'http' removed. SSE by AsyncEventSource. OTA update (/update) by webUI_update()
+ *   instead of ESP8266HTTPUpdateServer.
+ * - Batch move: POST <IP>/api/move with a JSON array of zone targets queues one MOVE command for
+ *   all zones. With binary frames it is sent as one FRAME_MOVE_REQ, the PIC stores all set
+ *   positions at once and moves the zones one after the other (STATUSflags bits 12..15: pending).
+ *   Without frames the zones are sent as single "Move:" commands.
+ * - Move coalescing: a MOVE is held in the queue for MOVE_WINDOW ms (ovc.ini), further moves are
+ *   merged into it meanwhile (latest target per zone wins). A slider or a fast controller no longer
+ *   sends a stream of "Move:" commands. The PIC takes over a new set position of the running zone.
+ * - Concurrent moves: BUDGET_MA and CONCURRENT (ovc.ini) are sent to the PIC ("Budget:") at
+ *   startup and after a PIC reset. With CONCURRENT > 1 the PIC moves up to CONCURRENT zones at
+ *   once, as long as the sum of their current limits fits into the budget.
+ * - PIC job queue (frame protocol version 3): <IP>/home?vz=0 homes all zones by "HomeAll:", the
+ *   PIC moves them back to its set positions (EEPROM journal); it works through its job queue
+ *   without further requests. The number of waiting PIC jobs is taken from the status (pic_jobs).
+ * - Calibration run: <IP>/calib?vz=1&max_mA=35 queues "Calib:" (closed - open - closed end stop),
+ *   the PIC learns the stroke time of the zone.
+ * - Baud rate negotiation (pic_baud_negotiate()): the PIC link starts at 38400 Bd, then the highest
+ *   common rate up to BAUD_MAX (ovc.ini, 500000 Bd) is negotiated with "Baud:" and verified at the
+ *   new rate, else the ESP falls back. Also with the PIC bootloader for the firmware download. After
+ *   a status timeout (PIC reset) the baud rate is negotiated again. The negotiation is a state
+ *   machine driven by job 'link' (pic_baud_poll()), it doesn't block the scheduler.
+ * - PIC parameter table ("Param:", see PIC param.c): the motion parameters (tick period, home
+ *   timeout, over current counts, max. duty, motion profile, log decimation) are tunable without
+ *   a firmware update. PIC_... keys in ovc.ini are sent at startup and after a PIC reset, <IP>/param
+ *   shows the values read from the PIC, <IP>/param?duty_max=80 sets one (stored in the PIC EEPROM).
  * 2024-03-11 v0.8
  * - Added data logger: <IP>/logdata? reads curr_log[] and bemf_log[] from PIC.
  * - Added VBsum to "info?" for testing BEMF sum-up for position control.
@@ -75,36 +131,140 @@
  * @todo - poor handling of refset[] (maybe by PIC?). 
  *       - home drive sometimes doesn't reset position.
  *       - Download of ovc.ini should be password protected or PSK should be encrypted in ovc.ini.
- *       - Firmware update via httpUpdater should be password protected.
+ *       - Firmware update via <IP>/update should be password protected.
  *       - Define enum ERRNOs globally (ESP + PIC)
  */
 
 // *** includes
 #include <ESP8266WiFi.h>
-#include <ESP8266WebServer.h>
-#include <ESP8266HTTPUpdateServer.h>
+#include <ESPAsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <Updater.h>
 #include <PubSubClient.h>
 //#include <WiFiClient.h>
 #include <ArduinoJson.h>
+#include <AsyncJson.h>
 #include <LittleFS.h>
 
 // *** function prototypes
+#define numVZ   4             // no. of available Valve Zones / motors
+
+typedef void (*pic_callback_t) (int error, const char *response);  // completion callback (pic.ino)
+
+/// Command types of the command queue (cmdq.ino)
+enum CMDtypes
+{
+  CMD_MOVE = 1,   //!< Move:vz,pos,mAx10 or FRAME_MOVE_REQ (several zones)
+  CMD_HOME,       //!< Home:vz,mAx10 or HomeAll:mAx10,mAx10 move (vz = 0: arg0, arg1)
+  CMD_VERSION,    //!< Version?
+  CMD_LOGDATA,    //!< LogData? (bulk transfer into logdata.csv)
+  CMD_BOOTLOAD,   //!< Bootload! (firmware download of hexfilename)
+  CMD_BUDGET,     //!< Budget:mAx10,n (current budget and max. zones of concurrent moves)
+  CMD_CALIB,      //!< Calib:vz,mAx10 (calibration run)
+  CMD_PARAM,      //!< Param:ix,value (PIC parameter table)
+  CMD_PARAMS,     //!< Param? (read all parameters)
+};
+
+/// States of a queued command
+enum CMDstates
+{
+  CMD_FREE = 0,   //!< slot never used
+  CMD_QUEUED,     //!< waiting for the PIC transport
+  CMD_SENT,       //!< sent, waiting for the response
+  CMD_DONE,       //!< acknowledged by PIC
+  CMD_ERROR,      //!< error response or timeout (see error)
+};
+
+typedef void (*sched_job_t) (void);   // job of the scheduler (sched.ino)
+
+struct TASK  //!< entry of the scheduler task table
+{
+  const char   *name;     //!< name of the job (statistics)
+  sched_job_t   job;      //!< function to run
+  uint32_t      period;   //!< [ms] period
+  uint32_t      deadline; //!< [ms] max. delay after becoming due
+  unsigned long due;      //!< [ms] next due time (millis())
+  uint32_t      runs;     //!< statistics: number of runs
+  uint32_t      overruns; //!< statistics: number of deadline misses
+  uint32_t      late_max; //!< statistics: [ms] max. delay
+  uint32_t      t_max;    //!< statistics: [µs] max. exec time
+  uint64_t      t_sum;    //!< statistics: [µs] sum of exec time
+};
+
+struct CMD  //!< entry of the command queue
+{
+  uint16_t  id;     //!< sequence number, returned to the web client
+  uint8_t   type;   //!< CMDtypes
+  uint8_t   state;  //!< CMDstates
+  uint8_t   vz;     //!< valve zone [1 .. 4], 0: several zones (MOVE)
+  uint8_t   zones;  //!< MOVE: zones to move (bit 0 = vz1)
+  uint8_t   todo;   //!< MOVE: zones not yet acknowledged by PIC
+  uint8_t   pos[numVZ + 1];   //!< set position [0 .. 100] % (index vz)
+  uint16_t  mAx10[numVZ + 1]; //!< current limit [0.1 mA] (index vz)
+  uint16_t  arg0;   //!< 1st argument of commands without zone (BUDGET: max. zones at once, PARAM: index, HOME: mAx10)
+  uint16_t  arg1;   //!< 2nd argument of commands without zone (BUDGET: total budget [0.1 mA], PARAM: value, HOME: mAx10 move)
+  int8_t    error;  //!< result (CMD_ERROR)
+  unsigned long t_queued; //!< [ms] time of queueing (millis(), coalescing window of MOVE)
+};
+
 extern int    cmd2pic (void);
+extern bool   pic_busy (void);
+extern void   pic_poll (void);
+extern int    pic_submit (const char *cmd, pic_callback_t done);
+extern int    pic_submit_frame (uint8_t type, const uint8_t *data, uint8_t len, pic_callback_t done);
+extern void   pic_subscribe (pic_callback_t callback);
+extern long   pic_baud_negotiate (long max);
+extern void   pic_baud_start (long max);
+extern bool   pic_baud_busy (void);
+extern void   pic_baud_poll (void);
+extern void   pic_set_baud (long baud);
 extern void   create_jStatus (char *dest, int len, bool pretty);
 
+extern int    cmdq_push (uint8_t type, uint8_t vz, uint8_t pos, uint16_t mAx10);
+extern int    cmdq_push_args (uint8_t type, uint16_t arg0, uint16_t arg1);
+extern int    cmdq_push_moves (uint8_t zones, const uint8_t *pos, const uint16_t *mAx10);
+extern CMD   *cmdq_peek (void);
+extern void   cmdq_done (int error);
+extern int    cmdq_pending (void);
+extern const CMD *cmdq_find (uint16_t id);
+extern void   cmdq_json (const CMD *cmd, char *dest, int len);
+extern void   cmdq_json_all (char *dest, int len);
+
+extern TASK  *sched_add (const char *name, sched_job_t job, uint32_t period, uint32_t deadline);
+extern void   sched_run (void);
+extern void   sched_trigger (TASK *task);
+extern void   sched_set_period (TASK *task, uint32_t period);
+extern void   sched_json (char *dest, int len);
+
+extern void   events_onConnect (AsyncEventSourceClient *client);
+
+extern bool   status_update (void);
+extern uint32_t status_version (void);
+extern const char *status_json (void);
+extern void   status_delta (uint32_t since, char *dest, int len);
+
 extern void   DS18B20_init (void);
 extern float  DS18B20_TempC (uint8_t index);
 
 extern int    fw_download (char *rec);
 
-extern void   webUI_bootload (void);
-extern void   webUI_home (void);
-extern void   webUI_info (void);
-extern void   webUI_move (void);
-extern void   webUI_notFound (void);
+extern void   webUI_api_move (AsyncWebServerRequest *request, JsonVariant &json);
+extern void   webUI_bootload (AsyncWebServerRequest *request);
+extern void   webUI_calib (AsyncWebServerRequest *request);
+extern void   webUI_home (AsyncWebServerRequest *request);
+extern void   webUI_logdata (AsyncWebServerRequest *request);
+extern void   webUI_update (AsyncWebServerRequest *request);
+extern void   webUI_updated (AsyncWebServerRequest *request);
+extern void   webUI_upload_fw (AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final);
+extern void   webUI_info (AsyncWebServerRequest *request);
+extern void   webUI_move (AsyncWebServerRequest *request);
+extern void   webUI_notFound (AsyncWebServerRequest *request);
+extern void   webUI_param (AsyncWebServerRequest *request);
+extern void   webUI_queue (AsyncWebServerRequest *request);
+extern void   webUI_sched (AsyncWebServerRequest *request);
 //extern void   webUI_root (void);
-extern void   webUI_save (void);
-extern void   webUI_status (void);
+extern void   webUI_save (AsyncWebServerRequest *request);
+extern void   webUI_status (AsyncWebServerRequest *request);
 
 extern void   OLED_init (void);
 extern void   OLED_show (unsigned row, char *s);
@@ -119,8 +279,23 @@ extern int    setup_ReadINI (const char *path);
 extern int    setup_WriteCstring (const char *path, const char *identifier, char *s);
 
 // *** private function prototypes
-extern void   getPIClogdata (void);
+extern int    getPIClogdata (void);
+extern void   job_display (void);
+extern void   job_events (void);
+extern void   job_link (void);
+extern void   job_mqtt (void);
+extern void   job_sensor (void);
+extern void   job_status (void);
+extern void   poll_adapt (bool active);
+extern void   param_push (void);
 extern void   getPICversion (void);
+extern void   pic_onBudget (int error, const char *response);
+extern void   pic_onFrame (int error, const char *response);
+extern void   pic_onHome (int error, const char *response);
+extern void   pic_onMove (int error, const char *response);
+extern void   pic_onParam (int error, const char *response);
+extern void   pic_onStatus (int error, const char *response);
+extern void   pic_onVersion (int error, const char *response);
 
 // *** data type, constant and macro definitions
 //#define DEBUG_OUTPUT_DS1820   1   /* enable serial monitor: status DS18B20 */
@@ -129,23 +304,37 @@ extern void   getPICversion (void);
 //#define DEBUG_OUTPUT_INI      1   /* enable serial monitor: INI file functions */
 //#define DEBUG_MQTT_PUBLISH    1   /* enable serial monitor: MQTT publish */
 
-#define numVZ   4             // no. of available Valve Zones / motors
-
-#define CYCLE_TIME    500   /* cycle time of main loop */
+#define POLL_FAST     100   /* [ms] default period of PIC status requests, while a zone is in process */
+#define POLL_IDLE     5000  /* [ms] default period of PIC status requests at rest */
+#define MOVE_WINDOW   300   /* [ms] default time a MOVE is held in the queue to merge further moves */
+#define BUDGET_MA     60.0  /* [mA] default total current budget of concurrent moves */
+#define PUSH_WATCHDOG 30000 /* [ms] period of PIC status requests, while the PIC pushes its status */
+#define PUSH_TIMEOUT  25000 /* [ms] max. time without pushed status (PIC heartbeat: 10 s) */
+#define LINK_TIME     1     /* [ms] period of job 'link' (PIC transport, command queue) */
+#define DISPLAY_TIME  500   /* [ms] period of job 'display' (OLED) */
+#define EVENTS_TIME   1000  /* [ms] period of job 'events' (keep-alive, triggered on status change) */
+#define SENSOR_TIME   1000  /* [ms] period of job 'sensor' (DS18B20, conversion takes 750 ms) */
+#define MQTT_TIME     1000  /* [ms] period of job 'mqtt' (connect / publish every mqttPeriod) */
 #define MAX_ACK_TIME  500   /* timeout in milliseconds for command acknowledge from PIC */
-
-// bitfields are not really the optimum - a boolean flag_move, flag_home, ... might be the better choice!?
-struct FLAGS  //!<   flags to start tasks within loop()
-{
-  uint8_t move     :1;  //!< 0 exec move
-  uint8_t home     :1;  //!< 1 exec home
-  uint8_t status   :1;  //!< 2 exec status
-  uint8_t save     :1;  //!< 3 exec save
-  uint8_t bootload :1;  //!< 4 update PIC firmware
-  uint8_t version  :1;  //!< 5 update PIC version
-  uint8_t logdata  :1;  //!< 6 reads log data from PIC
-  uint8_t          :1;  //!< 7 
-}; 
+#define PIC_E_TIMEOUT (-100)  /* transport error: no response within MAX_ACK_TIME (PIC errors: -1 .. -99) */
+#define PIC_E_FRAME   (-101)  /* transport error: binary frame with invalid length or CRC */
+#define PIC_E_BUSY    (-102)  /* transport error: transaction still open (cmd2pic()) */
+#define PIC_BAUD      38400 /* [Bd] baud rate of PIC firmware and bootloader after reset */
+#define BAUD_MAX      500000  /* [Bd] default max. baud rate negotiated with the PIC (ovc.ini) */
+#define CMDQ_SIZE     16    /* capacity of the command queue (see cmdq.ino) */
+#define NUM_PARAM     10    /* parameters of the PIC parameter table (see PIC param.h) */
+
+/* Binary frames (see PIC frame.h): SYNC | TYPE | LEN | DATA[LEN] | CRC16 (low, high) 
+ * CRC-16/CCITT (poly 0x1021, init 0xFFFF) over TYPE, LEN and DATA, all values little endian. */
+#define FRAME_SYNC        0xA5  /* first byte of a binary frame */
+#define FRAME_MAXDATA     32    /* max. payload bytes */
+#define FRAME_OVERHEAD    5     /* SYNC, TYPE, LEN, CRC16 */
+#define FRAME_STATUS_REQ  0x01  /* request status (no data) */
+#define FRAME_MOVE_REQ    0x02  /* move zones: n x (vz (u8), pos (u8), mAx10 (i16)) */
+#define FRAME_STATUS      0x81  /* status: pos1..4 (u8), mAx10 (i16), status (u16), vbemf_sum (i32), jobs (u8, version 3) */
+#define FRAME_STATUS_PUSH 0x82  /* unsolicited status (protocol version 2), same layout as FRAME_STATUS */
+#define FRAME_MOVE        0x83  /* move accepted: pending zones (u8) */
+#define FRAME_ERROR       0xFF  /* error response: errno (i8) */
 
 /* uint16_t status word (read from PIC)
  * Bit definitions/macros are more safe than structs, when using different compilers)
@@ -160,15 +349,16 @@ struct FLAGS  //!<   flags to start tasks within loop()
 #define VZ2(x)   ((x & 0x0020) >> 5)    /* 1: vz2 is under process */
 #define VZ3(x)   ((x & 0x0040) >> 6)    /* 1: vz3 is under process */
 #define VZ4(x)   ((x & 0x0080) >> 7)    /* 1: vz4 is under process */
-#define MOVE(x)  ((x & 0x0100)          /* 'move' is executing */
-#define HOME(x)  ((x & 0x0200)          /* 'home' is executing */
+#define MOVE(x)  ((x & 0x0100) >> 8)    /* 'move' is executing */
+#define HOME(x)  ((x & 0x0200) >> 9)    /* 'home' is executing */
+#define PEND(x)  ((x & 0xF000) >> 12)   /* zones waiting for 'move' as bit pattern (bit 0 = vz1) */
 
 /** LIBRARY INSTANCES */
 
 /** Webserver
  *  ========= */
-ESP8266WebServer server(80);
-ESP8266HTTPUpdateServer httpUpdater;
+AsyncWebServer   server(80);
+AsyncEventSource events("/events");   // Server-Sent Events (events.ino)
 
 
 /** MQTT client (publisher only)
@@ -179,7 +369,7 @@ PubSubClient  MQTTclient(espClient);
 
 /** Global variables
  *  =============== */
-char  ESPversion[32] = "v0.8";  // Version of ESP-Firmware
+char  ESPversion[32] = "v0.9";  // Version of ESP-Firmware
 char  PICversion[32] = "NN";    // Version of PIC-Firmware
 
 // WiFi credentials: Initial values are used for access point!
@@ -212,10 +402,31 @@ float     dTemp = 0.0;    // temperature adjust (ovc.ini)
 int       position[numVZ + 1] = {-1, 0, 65, 36, 100 };        // actual VZ positions (index 0 is dummy)
 bool      refset[numVZ + 1];                                  // home position set?
 int       vbemf_sum[numVZ + 1];
+bool      pic_frames = false;                                 // binary frames negotiated with PIC?
+bool      pic_push = false;                                   // PIC pushes status frames (version 2)?
+long      picBaud = PIC_BAUD;                                 // [Bd] current baud rate of the PIC link
+long      baudMax = BAUD_MAX;                                 // [Bd] max. baud rate to negotiate (ovc.ini)
+unsigned long pic_tpush;                                      // [ms] time of the last pushed status
+int       pic_jobs = 0;                                       // jobs waiting in the PIC job queue
 
 // Vars sourced by (html) User Interface 
-struct FLAGS  flags;      // processing flags (Web UI -> loop)
-int       vz = 0;         // selected valve zone (motor), [1 .. 4], 0 = none!
+bool      flag_save = false;  // save credentials and reboot (Web UI -> loop)
+bool      flag_reboot = false;  // reboot after OTA update (Web UI -> loop)
+bool      flag_frame = false; // negotiate binary frames (setup -> loop)
+bool      flag_baud = false;  // negotiate the baud rate (setup -> loop)
+bool      flag_status = false;  // status request due (job_status -> job_link)
+unsigned long pollFast = POLL_FAST; // [ms] status period while a zone is in process (ovc.ini)
+unsigned long pollIdle = POLL_IDLE; // [ms] status period at rest (ovc.ini)
+unsigned long moveWindow = MOVE_WINDOW; // [ms] coalescing window of MOVE commands (ovc.ini, 0: off)
+float     budget_mA = BUDGET_MA;    // [mA] total current budget of concurrent moves (ovc.ini)
+int       concurrent = 1;           // max. zones moved at once by the PIC (ovc.ini)
+/// Names of the PIC parameters (<IP>/param, ovc.ini: PIC_<NAME>), same order as ParamIds (PIC param.h)
+const char *paramName[NUM_PARAM] = { "tick_ms", "home_s", "overcurr", "mux_overcurr", "duty_max",
+                                     "duty_start", "duty_slow", "ramp_ms", "slow_pct", "log_div" };
+int       param[NUM_PARAM]    = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };  // read from the PIC (-1: unknown)
+int       paramIni[NUM_PARAM] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };  // ovc.ini (-1: PIC keeps its value)
+TASK     *task_status;        // job 'status' (period is adapted by poll_adapt())
+TASK     *task_events;        // job 'events' (triggered by status_update())
 int       set_pos[numVZ + 1]  = { -1, 0, 65, 36, 100 };       // valve set positions
 float     max_mA[numVZ + 1]   = { 0.0, 30.0, 30.0, 30.0, 30.0 };  // motor current limits [mA]
 
@@ -235,13 +446,13 @@ void setup ()
   int    error;
   String param;
 
-  /** - Initialize Serial (UART0) to 38400 Bd. \n
+  /** - Initialize Serial (UART0) to 38400 Bd (PIC_BAUD), a higher rate is negotiated by job_link. \n
    *    Serial uses UART0 which is mapped to pins GPIO1 (TX/pin22) and GPIO3 (RX/pin21).  
    *    For communication with the PIC µC, we remap UART0 to GPIO15 (TX': D8/pin16) and GPIO13 (RX': D7/pin7) by Serial.swap(). 
    *    Calling swap again maps UART0 back to GPIO1 and GPIO3. (Serial1/UART1 can not be used to receive).
    *    Weblink: https://esp8266-arduino.readthedocs.io/en/latest/reference.html "Serial".
    */
-  Serial.begin(38400);
+  Serial.begin(PIC_BAUD);
   Serial.swap();  // disconnect serial console on ESP8266 and swap connection to PIC µC
 
   /** - Initialize OLED Status Display \n
@@ -334,31 +545,46 @@ void setup ()
   Serial.swap();    // remap output to PIC
 #endif
 
-  flags.version = 1;  // try to read (new) PIC firmware version
+  flag_baud = true;   // negotiate the baud rate (first)
+  flag_frame = true;  // negotiate binary frames
+  pic_subscribe(pic_onStatus);  // receive pushed status frames
+  cmdq_push(CMD_VERSION, 0, 0, 0);  // try to read (new) PIC firmware version
+  cmdq_push_args(CMD_BUDGET, concurrent, (uint16_t)(10 * budget_mA));   // concurrent moves
+  param_push();                     // PIC parameters of ovc.ini
 
   /** - Setup Webserver for ESP ValveControl
    *  This implements our client request handlers. You can append the GET commands and parameters to the URI, e.g.
    *  http://192.168.2.75/move?vz=1&set_pos=25&max_mA=30   move selected valve to 25 % position.
    *  http://192.168.2.75/home?vz=3&max_mA=45              request homing of the selected valve.
+   *  http://192.168.2.75/calib?vz=3&max_mA=45             request a calibration run of the selected valve.
    *  http://192.168.2.75/status                           get status information (current, temperature, valve states)
    *  http://192.168.2.75/info                             get system information (Firmware releases, WiFi SSID)
+   *  http://192.168.2.75/param?duty_max=80                set a PIC parameter (without args: get all)
    */
 // server.on("/", handleRoot);  // handled by LittleFS -> invokes /index.html (our Web UI)
   server.on("/bootload", HTTP_GET, webUI_bootload);
   server.on("/move",     HTTP_GET, webUI_move);
+  server.addHandler(new AsyncCallbackJsonWebHandler("/api/move", webUI_api_move, 1024));   // POST, JSON
   server.on("/home",     HTTP_GET, webUI_home);
+  server.on("/calib",    HTTP_GET, webUI_calib);
+  server.on("/param",    HTTP_GET, webUI_param);
   server.on("/logdata",  HTTP_GET, webUI_logdata);
   server.on("/info",     HTTP_GET, webUI_info);
   server.on("/status",   HTTP_GET, webUI_status);
   server.on("/save",     HTTP_GET, webUI_save);
+  server.on("/queue",    HTTP_GET, webUI_queue);
+  server.on("/sched",    HTTP_GET, webUI_sched);
+  server.on("/update",   HTTP_GET, webUI_update);
+  server.on("/update",   HTTP_POST, webUI_updated, webUI_upload_fw);
+  events.onConnect(events_onConnect);
+  server.addHandler(&events);   // <IP>/events
   //server.on("/format");  // handled by LittleFS
   //server.on("/upload");  // handled by LittleFS
   //server.onNotFound(webUI_notFound);  // already handled by LittleFS
 
-  /** - Setup OTA httpUpdater
+  /** - OTA update: <IP>/update (see webUI_update())
         Weblink:  https://arduino-esp8266.readthedocs.io/en/latest/ota_updates/readme.html#web-browser
   */
-  httpUpdater.setup(&server);
   server.begin();
 
   if (strlen(mqtt_host) > 6)
@@ -367,103 +593,354 @@ void setup ()
     MQTTclient.setBufferSize(512);    // The maximum message size, including header (default is 256 bytes)
   }
 
+  /** - Register the jobs of loop() (in order of priority) */
+  sched_add("link",    job_link,    LINK_TIME,    5);
+  task_status = sched_add("status", job_status, pollIdle, pollFast);
+  task_events = sched_add("events", job_events, EVENTS_TIME, 20);
+  sched_add("display", job_display, DISPLAY_TIME, DISPLAY_TIME / 2);
+  sched_add("sensor",  job_sensor,  SENSOR_TIME,  SENSOR_TIME / 2);
+  sched_add("mqtt",    job_mqtt,    MQTT_TIME,    MQTT_TIME);
+
 } // setup()
 
 
 
 /** @brief  ESP8266 main loop
- *  - Process request handler and execute commands from UI
- *  - Periodically read status from PIC (valve controller)
- *  - Update OLED status display
+ *  Runs the jobs registered in setup() by the cooperative scheduler (see sched.ino):
+ *  - link:    assemble PIC responses, send queued commands and status requests
+ *  - status:  periodically request the status from PIC (valve controller), 
+ *             fast while a zone is in process, slow at rest (see poll_adapt())
+ *  - events:  push status changes to the Web UI (Server-Sent Events)
+ *  - display: update OLED status display
+ *  - sensor:  read temperature sensor
+ *  - mqtt:    publish status to MQTT broker
+ *  The PIC commands are submitted to the asynchronous transport (see pic.ino), the
+ *  responses are processed by the completion callbacks pic_onXxx(). 
+ *  Hence no job waits for the PIC.
+ *  The HTTP requests are processed by the asynchronous web server, independent of loop().
 */
 void loop ()
 {
-  unsigned long LoopStamp = millis();   // used to run main loop with constant execution time
-  int       error;
-  int       ival32;
-  uint16_t  uval;
-  char      buf[64];
-  char      *p;
+  sched_run();
+
+} // loop()
+
 
-  if (flags.move)       // MOVE command?
+/** @brief  Job 'link': drives the PIC transport. \n
+ *  Assembles the response of the open transaction. When the transport is idle, the next
+ *  pending action is started: (save &) reboot, frame negotiation, queued command, status request.
+ */
+void job_link (void)
+{
+  CMD   *cmd;
+  int   error;
+  uint8_t data[4 * numVZ];  // payload of FRAME_MOVE_REQ
+  uint8_t vz, n;
+
+  pic_poll();             // assemble PIC response (if any)
+  if (pic_busy()) return; // PIC transport not available
+
+  if (flag_save || flag_reboot)   // SAVE & REBOOT or REBOOT after OTA update?
   {
-   /* Send MOVE command regardless of reference points and other conditions - errors must be handled by PIC.
-    * Due to long execution time, the PIC µC acknowledges only reception of the command.
-    */    
-    sprintf(txbuf, "Move:%d,%d,%d", vz, set_pos[vz], (uint16_t)(10 * max_mA[vz]));      // Move:vz:set_pos[vz]:10 x max_mA[vz]
-    OLED_show(1, txbuf);    // optional show on OLED.row 1 (0..5)
-    error = cmd2pic();
-    // check if response contains command token ("Move"), else it is an error reponse
-    if (strncmp(rxbuf, "Move:", 5) != 0)  // compare first N chars of response with command
-    { /** @todo optional error handler, response might contain error number */
-      error = -2;
+    if (flag_save)
+    {
+      flag_save = false;
+      setup_WriteCstring((char *)"/ovc.ini", "SSID", ssid);
+      setup_WriteCstring((char *)"/ovc.ini", "PSK",  psk);
     }
-    flags.move = 0;
-  } // if flags.move
 
-  else if (flags.home)       // HOME command?
+    // reboot
+    OLED_show(0, (char *)"reBOOT-please wait..");
+    delay(500);   // (the response is sent by the async server meanwhile)
+    ESP.restart();
+  }
+
+  else if (flag_baud)   // negotiate the baud rate (state machine, see pic.ino)
   {
-   /* Send HOME command regardless of reference points and other conditions - errors must be handled by PIC.
-    * Due to long execution time, the PIC µC acknowledges only reception of the command.
-    */    
-    sprintf(txbuf, "Home:%d,%d", vz, (uint16_t)(10 * max_mA[vz]));      // Home:vz:10 x max_mA[vz]
-    OLED_show(1, txbuf);    // optional show on OLED.row 1 (0..5)
-    error = cmd2pic();
-    if (strncmp(rxbuf, "Home:", 5) != 0)  // compare first N chars of response with command
-    { /** @todo optional error handler, response might contain error number */
-      error = -3; 
-    }
-    flags.home = 0;
+    flag_baud = false;
+    pic_baud_start(baudMax);
   }
 
-  else if (flags.save)       // SAVE & REBOOT?
+  else if (pic_baud_busy())   // next step of the negotiation (no other command meanwhile)
   {
-    flags.save = 0;
-    setup_WriteCstring((char *)"/ovc.ini", "SSID", ssid);
-    setup_WriteCstring((char *)"/ovc.ini", "PSK",  psk);
+    pic_baud_poll();
+  }
 
-    // reboot
-    OLED_show(0, (char *)"reBOOT-please wait..");
-    server.send(200, "text/html", "Restart_Ok");
-    delay(500);
-    ESP.restart();
+  else if (flag_frame)  // negotiate binary frames
+  {
+    pic_submit("Frame?", pic_onFrame);
   }
 
-  else if (flags.bootload)       // Update PIC firmware
+  else if ((cmd = cmdq_peek()) != NULL)   // queued command (oldest first)?
   {
-    fw_download();
-    for (int i = 0; i < 4; i++) 
-    { // wait for PIC reboot
-      server.handleClient();
-      delay(500);    
-    }
-    flags.bootload = 0;
+    cmd->state = CMD_SENT;
+    switch (cmd->type)
+    {
+      case CMD_MOVE:
+       /* Send MOVE command regardless of reference points and other conditions - errors must be handled by PIC.
+        * Due to long execution time, the PIC µC acknowledges only reception of the command.
+        * Binary frames: all zones by one FRAME_MOVE_REQ, else one "Move:" per zone (see pic_onMove()).
+        */    
+        for (vz = 1; (vz < numVZ) && !(cmd->todo & (1 << (vz - 1))); vz++) ;  // first zone to send
+        if (pic_frames)
+        {
+          for (n = 0; vz <= numVZ; vz++)
+          {
+            if (!(cmd->todo & (1 << (vz - 1)))) continue;
+            data[n++] = vz;
+            data[n++] = cmd->pos[vz];
+            data[n++] = (uint8_t) cmd->mAx10[vz];
+            data[n++] = (uint8_t) (cmd->mAx10[vz] >> 8);
+          }
+          sprintf(txbuf, "Move:0x%X", cmd->todo);
+          OLED_show(1, txbuf);  // optional show on OLED.row 1 (0..5)
+          pic_submit_frame(FRAME_MOVE_REQ, data, n, pic_onMove);
+        }
+        else
+        {
+          sprintf(txbuf, "Move:%d,%d,%d", vz, cmd->pos[vz], cmd->mAx10[vz]);   // Move:vz:set_pos[vz]:10 x max_mA[vz]
+          OLED_show(1, txbuf);  // optional show on OLED.row 1 (0..5)
+          pic_submit(txbuf, pic_onMove);
+        }
+        break;
+
+      case CMD_HOME:
+       /* Send HOME command regardless of reference points and other conditions - errors must be handled by PIC.
+        * Due to long execution time, the PIC µC acknowledges only reception of the command.
+        */    
+        if (cmd->vz) sprintf(txbuf, "Home:%d,%d", cmd->vz, cmd->mAx10[cmd->vz]);  // Home:vz:10 x max_mA[vz]
+        else         sprintf(txbuf, "HomeAll:%u,%u", cmd->arg0, cmd->arg1);  // all zones, then back (PIC job queue)
+        OLED_show(1, txbuf);    // optional show on OLED.row 1 (0..5)
+        pic_submit(txbuf, pic_onHome);
+        break;
+
+      case CMD_VERSION:       // Update PIC version info
+        getPICversion();
+        break;
+
+      case CMD_LOGDATA:       // read logdata (curr_log[], bemf_log[]) from PIC
+        cmdq_done(getPIClogdata());
+        break;
+
+      case CMD_BOOTLOAD:      // Update PIC firmware
+        error = fw_download();
+        delay(2000);    // wait for PIC reboot
+        cmdq_done(error);
+        break;
+
+      case CMD_BUDGET:        // current budget and max. zones of concurrent moves
+        sprintf(txbuf, "Budget:%u,%u", cmd->arg1, cmd->arg0);
+        pic_submit(txbuf, pic_onBudget);
+        break;
+
+      case CMD_CALIB:         // calibration run (long execution time, acknowledged on reception)
+        sprintf(txbuf, "Calib:%d,%d", cmd->vz, cmd->mAx10[cmd->vz]);
+        OLED_show(1, txbuf);    // optional show on OLED.row 1 (0..5)
+        pic_submit(txbuf, pic_onHome);
+        break;
+
+      case CMD_PARAM:         // set a parameter of the PIC parameter table
+        sprintf(txbuf, "Param:%u,%u", cmd->arg0, cmd->arg1);
+        pic_submit(txbuf, pic_onParam);
+        break;
+
+      case CMD_PARAMS:        // read all parameters
+        pic_submit("Param?", pic_onParam);
+        break;
+
+      default:
+        cmdq_done(-1);
+        break;
+    } // switch
+  } // if queued command
+
+  /* Read status from PIC, result format: "Status:Pos1,Pos2,Pos3,Pos4,mAx10,0xstatus,0xvbemf_sum,jobs"  
+   * or FRAME_STATUS, if binary frames have been negotiated. */
+  else if (flag_status)
+  {
+    flag_status = false;
+    if (pic_frames) pic_submit_frame(FRAME_STATUS_REQ, NULL, 0, pic_onStatus);
+    else            pic_submit("Status?", pic_onStatus);
   }
 
-  else if (flags.logdata)       // read logdata (curr_log[], bemf_log[]) from PIC
+} // job_link ()
+
+
+/** @brief  Job 'status': requests the PIC status (sent by job_link, when the transport is idle).
+ *  While the PIC pushes its status, this is a watchdog only: if the heartbeat fails (p.e. PIC reset),
+ *  the frame protocol is negotiated again and the status is polled meanwhile.
+ */
+void job_status (void)
+{
+  flag_status = true;
+  if (pic_push && ((millis() - pic_tpush) > PUSH_TIMEOUT))
   {
-    getPIClogdata();
-    flags.logdata = 0;
+    pic_push = false;
+    flag_frame = true;
+    poll_adapt(VZ(status));
+    cmdq_push_args(CMD_BUDGET, concurrent, (uint16_t)(10 * budget_mA));   // (PIC reset?)
+    param_push();
   }
 
-  else if (flags.version)       // Update PIC version info
+} // job_status ()
+
+
+/** @brief  Queues the PIC parameters configured in ovc.ini (PIC_<NAME>) and a query of all
+ *  parameters (startup, PIC reset, firmware download). Parameters not configured keep the
+ *  values stored in the PIC EEPROM, the range is checked by the PIC.
+ */
+void param_push (void)
+{
+  for (int i = 0; i < NUM_PARAM; i++)
   {
-    getPICversion();
+    if (paramIni[i] >= 0) cmdq_push_args(CMD_PARAM, i, (uint16_t) paramIni[i]);
   }
+  cmdq_push_args(CMD_PARAMS, 0, 0);   // read all (PIC firmware without parameters: error)
+
+} // param_push ()
 
 
-  /* Repeatedly process request handler until mid of loop cycle   */
-  do
+/** @brief  Adapts the period of the status requests: pollFast while a zone is in process 
+ *  (or a MOVE/HOME has just been acknowledged), pollIdle at rest.
+ *  PUSH_WATCHDOG while the PIC pushes its status.
+ *  @param  bool active  true: a zone is in process
+ */
+void poll_adapt (bool active)
+{
+  if (pic_push) sched_set_period(task_status, PUSH_WATCHDOG);
+  else          sched_set_period(task_status, active ? pollFast : pollIdle);
+
+} // poll_adapt ()
+
+
+/** @brief  Job 'display': update OLED position display.
+ */
+void job_display (void)
+{
+  OLED_update_status();
+
+} // job_display ()
+
+
+/** @brief  Job 'sensor': read temperature sensor (index 0), usually the heating flow temperature.
+ */
+void job_sensor (void)
+{
+  tempC = DS18B20_TempC(0) + dTemp;
+  status_update();
+
+} // job_sensor ()
+
+
+/** @brief  Job 'mqtt': (re-)connects to the broker and publishes the status every mqttPeriod.
+ */
+void job_mqtt (void)
+{
+  /* MQTT: send data every xx seconds to broker. re-connect if connection is lost 
+   * Weblinks: 
+   * https://arduinojson.org/v5/assistant/
+   * https://arduinojson.org/v6/api/jsondocument/
+   * https://arduinojson.org/v6/how-to/reuse-a-json-document/
+   * https://arduinojson.org/v6/doc/serialization/
+   * https://arduinojson.org/v6/example/
+   * https://circuits4you.com/2019/01/11/nodemcu-esp8266-arduino-json-parsing-example/
+   */
+  mqttCurrentTime = millis();
+  if ((strlen(mqtt_host) > 6) && (WiFi.status() == WL_CONNECTED))
+  { // MQTT has been configured && WiFi is connected
+    if (MQTTclient.connected())
+    { // publish every mqttPeriod
+      if ((mqttCurrentTime - mqttLastPub) > mqttPeriod)
+      {
+        sprintf(mqtt_token, "%s/status", mqtt_prefix);
+        create_jStatus (jStatus, sizeof(jStatus), false);   // create minified JSON document
+        MQTTclient.publish(mqtt_token, jStatus);
+        mqttLastPub = mqttCurrentTime;
+
+#ifdef DEBUG_MQTT_PUBLISH
+        Serial.flush();
+        Serial.swap();
+        Serial.println(jStatus);
+        Serial.flush();
+        Serial.swap();
+#endif
+      }
+    } // if MQTT connected
+    else if ((mqttCurrentTime - mqttLastConnect) > (unsigned long) 30000)
+    { // try to (re-)connect every 30 s
+      MQTTclient.connect(mqtt_token);
+      mqttLastConnect = mqttCurrentTime;
+    }
+  } // if MQTT has been configured && WiFi is connected
+
+} // job_mqtt ()
+
+
+/** @brief Completion callback of the MOVE command: finishes the queued command. \n
+ *  FRAME_MOVE acknowledges all zones of the command. An ASCII "Move:" acknowledges one zone,
+ *  the command is queued again until all zones have been sent.
+ */
+void pic_onMove (int error, const char *response)
+{
+  CMD   *cmd = cmdq_peek();
+
+  if ((uint8_t) response[0] == FRAME_SYNC)  // binary frame (CRC has been checked by pic_poll())
   {
-    server.handleClient();  // mandatory
-  } while ((millis() - LoopStamp) < CYCLE_TIME/2);
+    if (!error && ((uint8_t) response[1] == FRAME_ERROR)) error = (int8_t) response[3];  // errno from PIC
+    else if (!error && ((uint8_t) response[1] != FRAME_MOVE)) error = -2;
+    else if (!error) cmd->todo = 0;
+  }
+  // check if response contains command token ("Move"), else it is an error reponse
+  else if (!error && (strncmp(response, "Move:", 5) != 0))  // compare first N chars of response with command
+  { /** @todo optional error handler, response might contain error number */
+    error = -2;
+  }
+  else if (!error) cmd->todo &= cmd->todo - 1;   // first zone acknowledged
+
+  if (!error) poll_adapt(true);   // follow the move
+  if (!error && cmd->todo) cmd->state = CMD_QUEUED;  // next zone
+  else cmdq_done(error);
+
+} // pic_onMove ()
 
 
-  /* Read status from PIC, result format: "Status:Pos1,Pos2,Pos3,Pos4,mAx10,0xstatus"  */
-  sprintf(txbuf, "Status?");
-  error = cmd2pic();
+/** @brief Completion callback of the HOME and CALIB commands: finishes the queued command.
+ */
+void pic_onHome (int error, const char *response)
+{
+  if (!error && (strncmp(response, "Home", 4) != 0) &&   // "Home:" or "HomeAll:" 
+                (strncmp(response, "Calib:", 6) != 0))
+  { /** @todo optional error handler, response might contain error number */
+    error = -3; 
+  }
+  if (!error) poll_adapt(true);   // follow the home run
+  cmdq_done(error);
+
+} // pic_onHome ()
+
+
+/** @brief Completion callback of the STATUS query and callback of pushed status frames. \n
+ *  Parses the status (ASCII or binary frame).
+ */
+void pic_onStatus (int error, const char *response)
+{
+  int       ival32;
+  uint16_t  uval;
+  char      buf[64];
+  const char *p;
+  const uint8_t *d = (const uint8_t *) &response[3];  // payload of binary frame
+
+  if ((uint8_t) response[0] == FRAME_SYNC)  // binary frame (CRC has been checked by pic_poll())
+  {
+    if (!error && (((uint8_t) response[1] != FRAME_STATUS) && ((uint8_t) response[1] != FRAME_STATUS_PUSH)))
+    {
+      error = -4;
+    }
+    else if (!error && (response[2] < 12)) error = -4;  // (13 bytes from version 3)
+    else if (!error && ((uint8_t) response[1] == FRAME_STATUS_PUSH)) pic_tpush = millis();
+  }
   // check if response contains command token ("Status:"), else it is an error reponse
-  if (strncmp(rxbuf, "Status:", 7) != 0)  // compare first N chars of response with command
+  else if (!error && (strncmp(response, "Status:", 7) != 0))  // compare first N chars of response with command
   { /// @todo optional error handler, response might contain error number
     error = -4; 
   }
@@ -472,18 +949,35 @@ void loop ()
   if (error)
   {
     /// @todo add appropriate error handler
+    if ((error == PIC_E_TIMEOUT) && (picBaud != PIC_BAUD)) flag_baud = true;  // PIC reset (38400 Bd)?
 #ifdef DEBUG_OUTPUT_STATUS
     Serial.flush();   // Waits for the transmission of outgoing serial data to complete
     Serial.swap();    // output to serial monitor
-    Serial.println(rxbuf);
+    Serial.println(response);
     Serial.flush();   // Waits for the transmission of outgoing serial data to complete
                       // (prior to Arduino 1.0, this instead removed any buffered incoming serial data)
     Serial.swap();    // output to PIC µC
 #endif
   }
+  else if ((uint8_t) response[0] == FRAME_SYNC)
+  { // fixed layout: pos1..4 (u8), mAx10 (i16), status (u16), vbemf_sum (i32), little endian
+    for (int i = 1; i <= 4; i++)
+    {
+      if (d[i - 1] <= 100) position[i] = d[i - 1];
+    }
+    uval = d[4] | (d[5] << 8);
+    if (uval <= 500) mAmps = (float) uval / 10.;
+    status = d[6] | (d[7] << 8);
+    refset[1] = REF1(status) ? 1 : 0;
+    refset[2] = REF2(status) ? 1 : 0;
+    refset[3] = REF3(status) ? 1 : 0;
+    refset[4] = REF4(status) ? 1 : 0;
+    vbemf_sum[1] = (int32_t) (d[8] | (d[9] << 8) | (d[10] << 16) | ((uint32_t) d[11] << 24));
+    pic_jobs = (response[2] >= 13) ? d[12] : 0;
+  }
   else
   { // find separator, then convert values
-    p = strstr(rxbuf, ":");
+    p = strstr(response, ":");
     for (int i = 1; i <= 4; i++)
     {
       if (p)    // positions[1..4]
@@ -515,13 +1009,18 @@ void loop ()
       if (sscanf(++p, "0x%08x", &ival32) == 1) 
       {
         vbemf_sum[1] = ival32;
-        // p = strstr(p, ",");
+        p = strstr(p, ",");
       } 
       else vbemf_sum[1] = -1;
     }
     else vbemf_sum[1] = -2;
+    pic_jobs = p ? atoi(++p) : 0;   // waiting jobs (PIC v0.9)
+  }
 
-
+  if (!error)
+  {
+    poll_adapt(MOVE(status) || HOME(status) || VZ(status) || PEND(status) || pic_jobs);
+    status_update();
 
 #ifdef DEBUG_OUTPUT_STATUS
       Serial.flush();   // Waits for the transmission of outgoing serial data to complete
@@ -534,65 +1033,16 @@ void loop ()
                         // (prior to Arduino 1.0, this instead removed any buffered incoming serial data)
       Serial.swap();    // output to PIC µC
 #endif
-
-    /* read temperature sensor (index 0), usually the heating flow temperature.  */
-    tempC = DS18B20_TempC(0) + dTemp;
-
-    /* update OLED position display */
-    OLED_update_status();
   }
 
-  /* Repeatedly process request handler until end of loop cycle */
-  do  
-  {
-    server.handleClient();  // mandatory
-  } while ((millis() - LoopStamp) < CYCLE_TIME);
-
-
-  /* MQTT: send data every xx seconds to broker. re-connect if connection is lost 
-   * Weblinks: 
-   * https://arduinojson.org/v5/assistant/
-   * https://arduinojson.org/v6/api/jsondocument/
-   * https://arduinojson.org/v6/how-to/reuse-a-json-document/
-   * https://arduinojson.org/v6/doc/serialization/
-   * https://arduinojson.org/v6/example/
-   * https://circuits4you.com/2019/01/11/nodemcu-esp8266-arduino-json-parsing-example/
-   */
-  mqttCurrentTime = millis();
-  if ((strlen(mqtt_host) > 6) && (WiFi.status() == WL_CONNECTED))
-  { // MQTT has been configured && WiFi is connected
-    if (MQTTclient.connected())
-    { // publish every mqttPeriod
-      if ((mqttCurrentTime - mqttLastPub) > mqttPeriod)
-      {
-        sprintf(mqtt_token, "%s/status", mqtt_prefix);
-        create_jStatus (jStatus, sizeof(jStatus), false);   // create minified JSON document
-        MQTTclient.publish(mqtt_token, jStatus);
-        mqttLastPub = mqttCurrentTime;
-
-#ifdef DEBUG_MQTT_PUBLISH
-        Serial.flush();
-        Serial.swap();
-        Serial.println(jStatus);
-        Serial.flush();
-        Serial.swap();
-#endif
-      }
-    } // if MQTT connected
-    else if ((mqttCurrentTime - mqttLastConnect) > (unsigned long) 30000)
-    { // try to (re-)connect every 30 s
-      MQTTclient.connect(mqtt_token);
-      mqttLastConnect = mqttCurrentTime;
-    }
-  } // if MQTT has been configured && WiFi is connected
-
-} // loop()
+} // pic_onStatus ()
 
 
 /** @brief This function creates the const char jStatus[] which can be used 
  *  by the webUI (/status) or published to the MQTT server.
  *  jStatus has the following JSON structure:
  *  { 
+ *  "version": 17,
  *  "mAmps": "0.1",
  *  "tempC": "24.4",
  *  "VZ1": { "Position": 10, "Set_Pos": 0, "Ref_Set": 1, "max_mA": 50.0 },
@@ -607,6 +1057,7 @@ void create_jStatus (char *dest, int len, bool pretty)
 {
   StaticJsonDocument<384> doc;  // recommended size for serializing 
 
+  doc["version"] = status_version();
   doc["mAmps"] = round(mAmps * 10) / 10.0;
   doc["tempC"] = round(tempC * 10) / 10.0;
 
@@ -616,11 +1067,6 @@ void create_jStatus (char *dest, int len, bool pretty)
   VZ1["Ref_Set"] = refset[1] ? 1 : 0;
   VZ1["max_mA"] = max_mA[1];
 
-  VZ1["Position"] = position[1];
-  VZ1["Set_Pos"] = set_pos[1];
-  VZ1["Ref_Set"] = refset[1] ? 1 : 0;
-  VZ1["max_mA"] = max_mA[1];
-
   JsonObject VZ2 = doc.createNestedObject("VZ2");
   VZ2["Position"] = position[2];
   VZ2["Set_Pos"] = set_pos[2];
@@ -645,129 +1091,92 @@ void create_jStatus (char *dest, int len, bool pretty)
 } // create_jStatus ()
 
 
-/** @brief  This function sends the command string in txbuf[] via UART to the PIC µC 
- *          and waits for a response or timeout. 
- *          The response is returned in global rxbuf[].
- *  @return int error  0: no error
- *                    -1: timeout
+/** @brief Request PIC Firmware Version, the response is saved in 'PICversion' by pic_onVersion().
 */
-int cmd2pic (void)
+void getPICversion (void)
 {
-  unsigned long tstart;
-  String  str;   
-  int     error = 0;
-  bool    eol;
-  char    c;
+  pic_submit("Version?", pic_onVersion);
 
-  // flush response buffer 
-  while (Serial.available() > 0) Serial.read();   // clean up serial input
-  eol = 0;
-  nrx = 0;
-  rxbuf[0] = '\0';  // flush rxbuf
+} // getPICversion()
 
-  Serial.println(txbuf);  // transmit query to PIC µC
-  tstart = millis();
 
-  // wait for eol := command ack (reception only, not yet execution)
-  for (error = 0; !eol && !error;  )
-  {
-    while (Serial.available() > 0 && !eol) 
-    {
-      c = Serial.read();
-      if (c == '\r') continue;  // skip
-      if (c == '\n') 
-      {
-        if (nrx < 2)  continue;
-        eol = true;
-        c = '\0';
-      }
-      if (nrx < sizeof(rxbuf))  // if not buffer overflow
-      {
-        rxbuf[nrx++] = c;       // store received char in rxbuf, increment count
-      }
-      else rxbuf[sizeof(rxbuf) - 1] = '\0'; // terminate rxbuf
-    } // while
-
-    if ((millis() - tstart) > MAX_ACK_TIME)
-    {
-      error = -1;  // timeout?
-/*
-      Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-      Serial.swap();    // output to serial monitor
-      Serial.println("cmd2pic: MAX_ACKTIME exceeded");
-      Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-      Serial.swap();    // output to PIC µC      
+/** @brief Completion callback of the VERSION query.
 */
-    }
-    server.handleClient();      // process WebUI during wait
-  } // for
-
-  if (eol)  // we got a response
+void pic_onVersion (int error, const char *response)
+{
+  if (!error && (strncmp(response, "Version:", 8) == 0))  // compare first N chars of response with command
   { 
-    str = String(rxbuf);
-    if (str.startsWith("ERROR"))
-    {
-      error = str.substring(5).toInt();
-    }
-    /** @todo response could contain an error mesg - how to handle this?)
-      TEST: * /
-      Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-      Serial.swap();    // output to serial monitor
+    strncpy(PICversion, &response[9], sizeof(PICversion));
+    PICversion[sizeof(PICversion) - 1] = '\0';
+  }
+  else if (!error) error = -5;  // unexpected response
+  cmdq_done(error);
 
-      Serial.print ("> ");
-      Serial.println(txbuf);  // copy output to serial monitor
+} // pic_onVersion()
 
-      Serial.print ("< ");
-      Serial.println(rxbuf);
-      Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-      Serial.swap();    // output to PIC µC
-    */
-  } // if
-  else  // no response (timeout)
-  { 
-    error = -2; // timeout
-/*
-    Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-    Serial.swap();    // output to serial monitor
-    Serial.print (txbuf);
-    Serial.println(": Timeout");  // copy output to serial monitor
-    Serial.flush();   // Waits for the transmission of outgoing serial data to complete
-    Serial.swap();    // output to PIC µC
-*/    
-    /** @todo show err mesg in LCD (and WebUI? / status?) */
-  } // else
 
-  return (error);
+/** @brief Completion callback of the BUDGET command (PIC firmware without concurrent moves
+ *  answers with an error, the zones are then moved one after the other).
+*/
+void pic_onBudget (int error, const char *response)
+{
+  if (!error && (strncmp(response, "Budget:", 7) != 0)) error = -6;  // unexpected response
+  cmdq_done(error);
 
-} // cmd2pic
+} // pic_onBudget()
 
 
-/** @brief Read PIC Firmware Version and save in 'PICversion'
+/** @brief Completion callback of the PARAM and PARAMS commands: "Param:v0,v1,..." (all parameters in the
+ *  order of paramName[]) is taken into param[].
 */
-void getPICversion (void)
+void pic_onParam (int error, const char *response)
 {
-  int error;
+  const char  *p = &response[6];
 
-  sprintf(txbuf, "Version?");
-  error = cmd2pic();
-  if (!error && (strncmp(rxbuf, "Version:", 8) == 0))  // compare first N chars of response with command
-  { 
-    strncpy(PICversion, &rxbuf[9], sizeof(PICversion));
-    PICversion[sizeof(PICversion) - 1] = '\0';
-    flags.version = 0;
+  if (!error && (strncmp(response, "Param:", 6) == 0))
+  {
+    for (int i = 0; (i < NUM_PARAM) && p; i++)
+    {
+      param[i] = atoi(p);
+      if ((p = strchr(p, ',')) != NULL) p++;
+    }
   }
+  else if (!error) error = -6;  // unexpected response
+  cmdq_done(error);
 
-} // getPICversion()
+} // pic_onParam()
+
+
+/** @brief Completion callback of the FRAME negotiation. \n
+ *  "Frame:<version>" enables binary frames, version 2 the pushed status frames,
+ *  version 3 adds the number of waiting PIC jobs to the status frame.
+ *  An error response (firmware without frame support) keeps the ASCII protocol. 
+ *  On timeout the negotiation is repeated.
+ */
+void pic_onFrame (int error, const char *response)
+{
+  int   version = 0;
+
+  if (!error && (strncmp(response, "Frame:", 6) == 0)) version = atoi(&response[6]);
+  pic_frames = (version >= 1);
+  pic_push = (version >= 2);
+  pic_tpush = millis();
+  poll_adapt(VZ(status));
+  if (error != PIC_E_TIMEOUT) flag_frame = false;
+
+} // pic_onFrame()
 
 
 /** @brief Read LogData from PIC and save in LittleFS as file 'logdata.csv'
+ *  @return int error  0: no error, else error of LogData? request or -1: can't create logfile
 */
-void getPIClogdata (void)
+int getPIClogdata (void)
 {
   unsigned long tstart;
   File logfile;
   String  str;   
   int     error = 0;
+  int     result = -1;  // preset: can't create logfile
   bool    eol;
   char    c;
 
@@ -778,6 +1187,7 @@ void getPIClogdata (void)
     
     sprintf(txbuf, "LogData?"); // send request to PIC
     error = cmd2pic();
+    result = error ? error : -5;  // preset: error or unexpected response
     if (!error && (strncmp(rxbuf, "LogData:", 8) == 0))  // compare first N chars of response
     { 
       do 
@@ -809,17 +1219,18 @@ void getPIClogdata (void)
           {
             error = -1;  // timeout?
           }
-          server.handleClient();      // process WebUI during reception
+          yield();                    // (WebUI is served by the async server)
         } // for
 
-        if (eol)  // we received a record
+        if (eol && ((uint8_t) rxbuf[0] != FRAME_SYNC))  // we received a record (not a status frame)
         { 
           logfile.println(rxbuf);
           // logfile.writeString(rxbuf);
         }
-        server.handleClient();  // mandatory
+        yield();
       } while (!error); // read until timeout, don't use fix limit
       OLED_show(1, (char *)"Logfile complete!");
+      result = 0;   // final timeout terminates the transfer
     }
     logfile.print("Error: ");
     logfile.println(error);
@@ -829,5 +1240,6 @@ void getPIClogdata (void)
   {
     OLED_show(1, (char *)"Can't create logfile");
   }
+  return (result);
 
 } // getPIClogdata()
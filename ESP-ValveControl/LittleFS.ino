@@ -21,12 +21,14 @@
   Lesser General Public License for more details.
 *******************************************************************/
 // Diese Version von LittleFS sollte als Tab eingebunden werden.
-// #include <LittleFS.h> #include <ESP8266WebServer.h> müssen im Haupttab aufgerufen werden
-// Die Funktionalität des ESP8266 Webservers ist erforderlich.
+// #include <LittleFS.h> #include <ESPAsyncWebServer.h> müssen im Haupttab aufgerufen werden
+// Die Funktionalität des (Async) Webservers ist erforderlich.
 // "server.onNotFound()" darf nicht im Setup des ESP8266 Webserver stehen.
 // Die Funktion "setupFS();" muss im Setup aufgerufen werden.
 /**************************************************************************************/
 // @note (deKlaus): Changes for OpenValveControl are marked by this key.
+// @note (deKlaus): 2026-10-16 ported to ESPAsyncWebServer (AsyncWebServerRequest *request instead of
+//       the global ESP8266WebServer). Files are sent by AsyncFileResponse in chunks, without blocking loop().
 
 #include <list>
 #include <tuple>
@@ -39,13 +41,13 @@ void setupFS() {                            // Funktionsaufruf "setupFS();" muss
   LittleFS.begin();
   server.on("/format", formatFS);
   server.on("/upload", HTTP_POST, sendResponse, handleUpload);
-  server.onNotFound([]() {
-    if (!handleFile(server.urlDecode(server.uri())))
-      server.send(404, "text/plain", "FileNotFound");
+  server.onNotFound([](AsyncWebServerRequest *request) {
+    if (!handleFile(request, request->url()))   // @note (deKlaus): url() is already decoded
+      request->send(404, "text/plain", "FileNotFound");
   });
 }
 
-bool handleList() {                         // Senden aller Daten an den Client
+bool handleList(AsyncWebServerRequest *request) {   // Senden aller Daten an den Client
   FSInfo fs_info;  LittleFS.info(fs_info);  // Füllt FSInfo Struktur mit Informationen über das Dateisystem
   Dir dir = LittleFS.openDir("/");
   using namespace std;
@@ -65,8 +67,8 @@ bool handleList() {                         // Senden aller Daten an den Client
       dirList.emplace_back("", dir.fileName(), dir.fileSize());
     }
   }
-  dirList.sort([](const records & f, const records & l) {                  // Dateien sortieren
-    if (server.arg(0) == "1") {
+  dirList.sort([request](const records & f, const records & l) {           // Dateien sortieren
+    if (request->arg((size_t) 0) == "1") {
       return get<2>(f) > get<2>(l);
     } else {
       for (uint8_t i = 0; i < 31; i++) {
@@ -93,7 +95,7 @@ bool handleList() {                         // Senden aller Daten an den Client
   temp += ",{\"usedBytes\":\"" + formatBytes(fs_info.usedBytes) +                      // Berechnet den verwendeten Speicherplatz
           "\",\"totalBytes\":\"" + formatBytes(fs_info.totalBytes) +                   // Zeigt die Größe des Speichers
           "\",\"freeBytes\":\"" + (fs_info.totalBytes - fs_info.usedBytes) + "\"}]";   // Berechnet den freien Speicherplatz
-  server.send(200, "application/json", temp);
+  request->send(200, "application/json", temp);
   return true;
 }
 
@@ -109,60 +111,71 @@ void deleteRecursive(const String &path) {
   LittleFS.rmdir(path);
 }
 
-bool handleFile(String &&path) {
-  if (server.hasArg("new")) {
-    String folderName {server.arg("new")};
+bool handleFile(AsyncWebServerRequest *request, String path) {
+  if (request->hasArg("new")) {
+    String folderName {request->arg("new")};
     for (auto& c : {34, 37, 38, 47, 58, 59, 92}) for (auto& e : folderName) if (e == c) e = 95;    // Ersetzen der nicht erlaubten Zeichen
     LittleFS.mkdir(folderName);
   }
-  else if (server.hasArg("sort")) {
-    return handleList();
+  else if (request->hasArg("sort")) {
+    return handleList(request);
   }
-  else if (server.hasArg("delete")) {
-    deleteRecursive(server.arg("delete"));
-    sendResponse();
+  else if (request->hasArg("delete")) {
+    deleteRecursive(request->arg("delete"));
+    sendResponse(request);
     return true;
   }
 
-  if (!LittleFS.exists("fs.html")) server.send(200, "text/html", LittleFS.begin() ? HELPER : WARNING);     // ermöglicht das hochladen der fs.html
+  // @note (deKlaus): only one response per request (async server), hence return after send
+  if (!LittleFS.exists("fs.html")) {        // ermöglicht das hochladen der fs.html
+    request->send_P(200, "text/html", LittleFS.begin() ? HELPER : WARNING);
+    return true;
+  }
   if (path.endsWith("/")) path += "index.html";
-  if (path == "/spiffs.html") sendResponse(); // Vorübergehend für den Admin Tab
+  if (path == "/spiffs.html") {             // Vorübergehend für den Admin Tab
+    sendResponse(request);
+    return true;
+  }
 
   // return LittleFS.exists(path) ? ({File f = LittleFS.open(path, "r"); server.streamFile(f, mime::getContentType(path)); f.close(); true;}) : false;
   // @note (deKlaus): For OpenValveControl this line was replaced  with:
-  String ContentType = mime::getContentType(path);
+  String ContentType;   // @note (deKlaus): empty: AsyncFileResponse derives it from the file extension
   if (path.endsWith("ovc.ini")) ContentType = "text/plain; charset=UTF-8";
-  return LittleFS.exists(path) ? ({File f = LittleFS.open(path, "r"); server.streamFile(f, ContentType); f.close(); true;}) : false;
+  // @note (deKlaus): 2026-10-16 AsyncFileResponse instead of server.streamFile() (non-blocking)
+  if (!LittleFS.exists(path)) return false;
+  request->send(LittleFS, path, ContentType);
+  return true;
 }
 
-void handleUpload() {                                                                  // Dateien ins Filesystem schreiben
-  static File fsUploadFile;
-  HTTPUpload& upload = server.upload();
-  if (upload.status == UPLOAD_FILE_START) {
-    if (upload.filename.length() > 31) {  // Dateinamen kürzen
-      upload.filename = upload.filename.substring(upload.filename.length() - 31, upload.filename.length());
+// @note (deKlaus): upload handler of ESPAsyncWebServer, called for each received chunk of the file
+void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
+  static File fsUploadFile;                                                            // Dateien ins Filesystem schreiben
+  if (index == 0) {
+    String name {filename};
+    if (name.length() > 31) {  // Dateinamen kürzen
+      name = name.substring(name.length() - 31, name.length());
     }
-    printf(PSTR("handleFileUpload Name: /%s\n"), upload.filename.c_str());
-    fsUploadFile = LittleFS.open(server.arg(0) + "/" + server.urlDecode(upload.filename), "w");
-  } else if (upload.status == UPLOAD_FILE_WRITE) {
-    printf(PSTR("handleFileUpload Data: %u\n"), upload.currentSize);
-    fsUploadFile.write(upload.buf, upload.currentSize);
-  } else if (upload.status == UPLOAD_FILE_END) {
-    printf(PSTR("handleFileUpload Size: %u\n"), upload.totalSize);
+    printf(PSTR("handleFileUpload Name: /%s\n"), name.c_str());
+    fsUploadFile = LittleFS.open(request->arg("f") + "/" + name, "w");
+  }
+  printf(PSTR("handleFileUpload Data: %u\n"), len);
+  fsUploadFile.write(data, len);
+  if (final) {
+    printf(PSTR("handleFileUpload Size: %u\n"), index + len);
     fsUploadFile.close();
+    setup_ReadINI("/ovc.ini");   // @note (deKlaus): added for OpenValveControl
   }
-
-  setup_ReadINI("/ovc.ini");   // @note (deKlaus): added for OpenValveControl
 }
 
-void formatFS() {       // Formatiert das Filesystem
+void formatFS(AsyncWebServerRequest *request) {       // Formatiert das Filesystem
   LittleFS.format();
-  sendResponse();
+  sendResponse(request);
 }
 
-void sendResponse() {
-  server.sendHeader("Location", "fs.html");
-  server.send(303, "message/http");
+void sendResponse(AsyncWebServerRequest *request) {
+  AsyncWebServerResponse *response = request->beginResponse(303, "message/http");
+  response->addHeader("Location", "fs.html");
+  request->send(response);
 }
 
 const String formatBytes(size_t const& bytes) {                                        // lesbare Anzeige der Speichergrößen
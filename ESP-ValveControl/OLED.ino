@@ -29,6 +29,8 @@
 /*  Change Log:
  *  2023-11-23 v0.6
  *  - First issue
+ *  2026-10-16 v0.9
+ *  - Temperature is updated while the PIC status reports no MOVE or HOME.
  */
 
 /*  We use the "graphics" library. If you prefer the "8x8" OLED lib you have to replace all graphics output 
@@ -138,7 +140,7 @@ void OLED_update_status (void)
   u8g2.sendBuffer();
 
 // update temperature (when stationary)
-  if (!flags.move && !flags.home)
+  if (!MOVE(status) && !HOME(status))
   {
     u8g2.setDrawColor(0);
     u8g2.drawBox(0, PXrow[0] + 1, 128 - w, PXrow[1] - PXrow[0]);
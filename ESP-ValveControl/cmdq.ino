@@ -0,0 +1,260 @@
+/** @file  cmdq.ino
+ *  @author  (c) Klaus Deutschkämer (https://github.com/deklaus)
+ *  License: This software is licensed under the European Union Public Licence EUPL-1.2
+ *           (see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12 for details).
+ *
+ *  @brief Command queue (Web UI -> loop -> PIC). \n
+ *  The request handlers append commands (move, home, version, logdata, bootload) by cmdq_push(),
+ *  loop() sends the oldest pending command as soon as the PIC transport is idle and the
+ *  completion callback finishes it by cmdq_done(). The queue is a ring buffer of CMDQ_SIZE
+ *  entries: finished entries are kept (with their result) until the slot is reused, so the
+ *  state of a command can be read by its id (see webUI_queue()).
+ *  Coalescing: a MOVE is held for moveWindow ms, moves queued meanwhile are merged into it.
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue (replaces struct FLAGS move, home, version, logdata and bootload)
+ *  - Added cmdq_push_moves(): one MOVE command for several zones (<IP>/api/move)
+ *  - MOVE coalescing: moves are merged into the newest MOVE not yet sent (cmdq_coalesce())
+ *  - Added cmdq_push_args(): commands without zone (BUDGET) keep their arguments in arg0/arg1
+ *  - Added CMD_PARAM and CMD_PARAMS (PIC parameter table), their arguments in arg0/arg1
+ */
+
+// *** data type, constant and macro definitions
+// *** global variables
+// *** private variables
+static CMD      cmdq[CMDQ_SIZE];  // ring buffer
+static uint8_t  cmdq_head = 0;    // next free slot
+static uint8_t  cmdq_tail = 0;    // oldest pending command
+static uint8_t  cmdq_count = 0;   // number of pending commands (queued or sent)
+static uint16_t cmdq_id = 0;      // id of the last queued command
+
+// *** private function prototypes
+static CMD *cmdq_coalesce (void);
+static void cmdq_set_move (CMD *cmd, uint8_t vz, uint8_t pos, uint16_t mAx10);
+
+// *** public function bodies
+
+/** @brief  Appends a command to the queue.
+ *  @param  uint8_t type    CMD_MOVE, CMD_HOME, CMD_VERSION, CMD_LOGDATA, CMD_BOOTLOAD
+ *                          or CMD_CALIB
+ *  @param  uint8_t vz      valve zone [1 .. 4] (MOVE, HOME, CALIB), 0 (other commands)
+ *  @param  uint8_t pos     set position [0 .. 100] (MOVE)
+ *  @param  uint16_t mAx10  current limit / 0.1 mA (MOVE, HOME, CALIB)
+ *  @return int  id of the command (> 0), or -1 if the queue is full
+ *  @note   A MOVE is merged into the newest MOVE not yet sent, the id of this one is returned.
+ */
+int cmdq_push (uint8_t type, uint8_t vz, uint8_t pos, uint16_t mAx10)
+{
+  CMD *cmd;
+
+  if ((type == CMD_MOVE) && ((cmd = cmdq_coalesce()) != NULL))
+  {
+    cmdq_set_move(cmd, vz, pos, mAx10);   // latest target wins
+    return (cmd->id);
+  }
+
+  if (cmdq_count >= CMDQ_SIZE) return (-1);   // full: all slots pending
+
+  if (++cmdq_id == 0) cmdq_id = 1;  // id 0 is invalid
+
+  cmd = &cmdq[cmdq_head];
+  cmd->id    = cmdq_id;
+  cmd->type  = type;
+  cmd->state = CMD_QUEUED;
+  cmd->vz    = vz;
+  cmd->zones = ((vz >= 1) && (vz <= numVZ)) ? (1 << (vz - 1)) : 0;
+  cmd->todo  = cmd->zones;
+  if (vz <= numVZ)
+  {
+    cmd->pos[vz]   = pos;
+    cmd->mAx10[vz] = mAx10;
+  }
+  cmd->arg0  = 0;
+  cmd->arg1  = 0;
+  cmd->error = 0;
+  cmd->t_queued = millis();
+
+  cmdq_head = (cmdq_head + 1) % CMDQ_SIZE;
+  cmdq_count++;
+
+  return (cmd->id);
+
+} // cmdq_push ()
+
+
+/** @brief  Appends a command without zone (zones and todo are 0) and its arguments.
+ *  @param  uint8_t type     CMD_BUDGET, CMD_PARAM, CMD_PARAMS or CMD_HOME (all zones)
+ *  @param  uint16_t arg0    max. zones at once (BUDGET), parameter index (PARAM), mAx10 (HOME)
+ *  @param  uint16_t arg1    total current budget / 0.1 mA (BUDGET), value (PARAM), mAx10 move (HOME)
+ *  @return int  id of the command (> 0), or -1 if the queue is full
+ */
+int cmdq_push_args (uint8_t type, uint16_t arg0, uint16_t arg1)
+{
+  CMD *cmd;
+
+  if (cmdq_push(type, 0, 0, 0) < 0) return (-1);
+  cmd = &cmdq[(cmdq_head + CMDQ_SIZE - 1) % CMDQ_SIZE];     // the entry just queued
+  cmd->arg0 = arg0;
+  cmd->arg1 = arg1;
+
+  return (cmd->id);
+
+} // cmdq_push_args ()
+
+
+/** @brief  Appends a MOVE command for several zones to the queue.
+ *  @param  uint8_t zones     zones to move (bit 0 = vz1)
+ *  @param  uint8_t *pos      set positions [0 .. 100] (index vz)
+ *  @param  uint16_t *mAx10   current limits / 0.1 mA (index vz)
+ *  @return int  id of the command (> 0), or -1 if the queue is full
+ *  @note   The zones are merged into the newest MOVE not yet sent, if any (see cmdq_push()).
+ */
+int cmdq_push_moves (uint8_t zones, const uint8_t *pos, const uint16_t *mAx10)
+{
+  CMD *cmd;
+
+  if ((cmd = cmdq_coalesce()) == NULL)
+  {
+    if (cmdq_push(CMD_MOVE, 0, 0, 0) < 0) return (-1);
+    cmd = &cmdq[(cmdq_head + CMDQ_SIZE - 1) % CMDQ_SIZE];   // the entry just queued
+  }
+  for (int vz = 1; vz <= numVZ; vz++)
+  {
+    if (zones & (1 << (vz - 1))) cmdq_set_move(cmd, vz, pos[vz], mAx10[vz]);
+  }
+
+  return (cmd->id);
+
+} // cmdq_push_moves ()
+
+
+/** @brief  Returns the oldest pending command (state CMD_QUEUED or CMD_SENT), or NULL.
+ *  NULL also while the oldest command is a MOVE within its coalescing window (moveWindow).
+ */
+CMD *cmdq_peek (void)
+{
+  CMD *cmd = &cmdq[cmdq_tail];
+
+  if (!cmdq_count) return (NULL);
+  if ((cmd->type == CMD_MOVE) && (cmd->state == CMD_QUEUED) && 
+      ((millis() - cmd->t_queued) < moveWindow)) return (NULL);  // hold: collect further moves
+
+  return (cmd);
+
+} // cmdq_peek ()
+
+
+/** @brief  Finishes the oldest pending command.
+ *  @param  int error  0: CMD_DONE, else CMD_ERROR (error number saved in the entry)
+ */
+void cmdq_done (int error)
+{
+  CMD *cmd;
+
+  if (!cmdq_count) return;
+
+  cmd = &cmdq[cmdq_tail];
+  cmd->error = error;
+  cmd->state = error ? CMD_ERROR : CMD_DONE;
+
+  cmdq_tail = (cmdq_tail + 1) % CMDQ_SIZE;
+  cmdq_count--;
+
+} // cmdq_done ()
+
+
+/** @brief  Returns the number of pending commands.
+ */
+int cmdq_pending (void)
+{
+  return (cmdq_count);
+
+} // cmdq_pending ()
+
+
+/** @brief  Returns the queue entry with the given id, or NULL if it has been overwritten.
+ */
+const CMD *cmdq_find (uint16_t id)
+{
+  for (int i = 0; i < CMDQ_SIZE; i++)
+  {
+    if ((cmdq[i].state != CMD_FREE) && (cmdq[i].id == id)) return (&cmdq[i]);
+  }
+  return (NULL);
+
+} // cmdq_find ()
+
+
+/** @brief  Writes the queue entry as JSON object into dest[len].
+ *  p.e. {"id":17,"cmd":"move","vz":2,"zones":2,"state":"done","error":0} (max. 79 chars)
+ */
+void cmdq_json (const CMD *cmd, char *dest, int len)
+{
+  static const char *types[]  = { "", "move", "home", "version", "logdata", "bootload", "budget", "calib", "param", "params" };
+  static const char *states[] = { "free", "queued", "sent", "done", "error" };
+
+  snprintf(dest, len, "{\"id\":%u,\"cmd\":\"%s\",\"vz\":%u,\"zones\":%u,\"state\":\"%s\",\"error\":%d}",
+    cmd->id, types[cmd->type], cmd->vz, cmd->zones, states[cmd->state], cmd->error);
+
+} // cmdq_json ()
+
+
+/** @brief  Writes all used queue entries (oldest first) as JSON array into dest[len].
+ */
+void cmdq_json_all (char *dest, int len)
+{
+  int   n = 0;
+  int   ix;
+
+  n += snprintf(&dest[n], len - n, "[");
+  for (int i = 0; (i < CMDQ_SIZE) && (n < len); i++)
+  {
+    ix = (cmdq_head + i) % CMDQ_SIZE;   // oldest slot first
+    if (cmdq[ix].state == CMD_FREE) continue;
+    if (n > 1) n += snprintf(&dest[n], len - n, ",");
+    if (n < len) n += snprintf(&dest[n], len - n, "\n  ");
+    if (n < len)
+    {
+      cmdq_json(&cmdq[ix], &dest[n], len - n);
+      n += strlen(&dest[n]);
+    }
+  }
+  if (n < len) snprintf(&dest[n], len - n, "\n]\n");
+
+} // cmdq_json_all ()
+
+// *** private function bodies
+
+/** @brief  Returns the newest pending command, if it is a MOVE not yet sent (moves can be
+ *  merged into it), else NULL. Always NULL if coalescing is off (moveWindow = 0).
+ */
+static CMD *cmdq_coalesce (void)
+{
+  CMD *cmd = &cmdq[(cmdq_head + CMDQ_SIZE - 1) % CMDQ_SIZE];  // newest entry
+
+  if (!cmdq_count || !moveWindow) return (NULL);
+  if ((cmd->type != CMD_MOVE) || (cmd->state != CMD_QUEUED)) return (NULL);
+
+  return (cmd);
+
+} // cmdq_coalesce ()
+
+
+/** @brief  Sets the target of one zone of a MOVE command (adds the zone, if it's new).
+ */
+static void cmdq_set_move (CMD *cmd, uint8_t vz, uint8_t pos, uint16_t mAx10)
+{
+  if ((vz < 1) || (vz > numVZ)) return;
+
+  cmd->pos[vz]   = pos;
+  cmd->mAx10[vz] = mAx10;
+  cmd->zones |= (1 << (vz - 1));
+  cmd->todo  |= (1 << (vz - 1));
+  cmd->vz = (cmd->zones == (1 << (vz - 1))) ? vz : 0;   // 0: several zones
+
+} // cmdq_set_move ()
+
+/**
+ End of File
+ */
@@ -0,0 +1,70 @@
+/** @file  events.ino
+ *  @author  (c) Klaus Deutschkämer (https://github.com/deklaus)
+ *  License: This software is licensed under the European Union Public Licence EUPL-1.2
+ *           (see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12 for details).
+ *
+ *  @brief Server-Sent Events (SSE): pushes the status to the Web UI. \n
+ *  A browser subscribes by <IP>/events (EventSource, AsyncEventSource 'events') and receives the
+ *  complete status as first event (events_onConnect()). Afterwards job_events() sends an event with
+ *  the changed fields (see status_delta()) to all subscribers, as soon as the status snapshot has
+ *  changed. status_update() triggers the job, so the update is sent within the same loop pass.
+ *  Idle connections get a keep-alive event every SSE_KEEPALIVE ms. The events are queued per
+ *  subscriber by the async server, so a slow subscriber doesn't block the loop.
+ *  Event format (id = status version):
+ *    id: 18
+ *    event: status
+ *    data: { "version": 18, "mAmps": 12.3, ... }
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ *  - AsyncEventSource instead of own list of WiFiClient subscribers
+ */
+
+// *** data type, constant and macro definitions
+#define SSE_KEEPALIVE   15000   /* [ms] keep-alive interval of idle connections */
+
+// *** global variables
+// *** private variables
+static uint32_t       sse_version = 0;              // status version of the last event
+static unsigned long  sse_tsent;                    // [ms] time of the last event or keep-alive
+
+// *** public function bodies
+
+/** @brief  Callback of a new subscriber: sends the complete status as first event.
+ */
+void events_onConnect (AsyncEventSourceClient *client)
+{
+  status_update();
+  client->send(status_json(), "status", status_version());
+
+} // events_onConnect ()
+
+
+/** @brief  Job 'events': sends the fields changed since the last event to all subscribers,
+ *  or a keep-alive event to idle connections.
+ */
+void job_events (void)
+{
+  static char delta[512];
+
+  if (status_version() != sse_version)
+  {
+    status_delta(sse_version, delta, sizeof(delta));
+    sse_version = status_version();
+    if (events.count()) events.send(delta, "status", sse_version);
+    sse_tsent = millis();
+  }
+  else if ((millis() - sse_tsent) >= SSE_KEEPALIVE)
+  {
+    if (events.count()) events.send("", "keep-alive");
+    sse_tsent = millis();
+  }
+
+} // job_events ()
+
+// *** private function bodies
+
+/**
+ End of File
+ */
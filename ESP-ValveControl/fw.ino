@@ -6,6 +6,10 @@
  *  Change Log:
  *  2023-11-23 v0.6
  *  - First issue
+ *  2026-10-16 v0.9
+ *  - Binary frames are re-negotiated after download (new PIC firmware).
+ *  - No nested server.handleClient() (async web server).
+ *  - The baud rate is negotiated with the bootloader, after download again with the PIC firmware.
  *
  *  Weblinks: 
  *  https://arduino-esp8266.readthedocs.io/en/latest/filesystem.html
@@ -56,7 +60,9 @@ int fw_download (void)
         OLED_show(1, txbuf);
         error = 0;  // proceed (e.g. to terminate a bootloader with a single EOF record)
       }
+      pic_set_baud(PIC_BAUD);   // bootloader starts at 38400 Bd
       delay(2000);  // allow PIC to reboot (and to read OLED)
+      pic_baud_negotiate(baudMax);
 
       for (error = 0; hexfile.available() && !error; )
       { 
@@ -98,14 +104,21 @@ int fw_download (void)
           str.toCharArray(txbuf, 8);   // truncate: :NNAAAA (OLED row up to 21 chars)
           OLED_show(1, txbuf);
         }
-        server.handleClient();  // mandatory
+        yield();    // (WebUI is served by the async server)
       } // for
       hexfile.close();
 
       /* after completion show success message ("EOF record")
          add 2 s delay, to not override with temperature */
       delay(2000);
-      flags.version = 1;  // try to read (new) PIC firmware version
+      pic_set_baud(PIC_BAUD);   // (new) PIC firmware starts at 38400 Bd
+      flag_baud = true;
+      pic_frames = false; // (new) PIC firmware may not support binary frames
+      pic_push = false;
+      flag_frame = true;  // negotiate binary frames
+      cmdq_push(CMD_VERSION, 0, 0, 0);  // try to read (new) PIC firmware version
+      cmdq_push_args(CMD_BUDGET, concurrent, (uint16_t)(10 * budget_mA));   // concurrent moves
+      param_push();                     // PIC parameters of ovc.ini
 
     } // if file open
 
@@ -0,0 +1,506 @@
+/** @file  pic.ino
+ *  @author  (c) Klaus Deutschkämer (https://github.com/deklaus)
+ *  License: This software is licensed under the European Union Public Licence EUPL-1.2
+ *           (see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12 for details).
+ *
+ *  @brief Asynchronous UART transport to the PIC µC. \n
+ *  A command is submitted by pic_submit() and returns immediately. The response is
+ *  assembled byte by byte by pic_poll(), which must be called from loop(). When the
+ *  response is complete (or the transaction timed out), the completion callback is
+ *  invoked with the error code and the response string (rxbuf[]).
+ *  Only one transaction can be open at a time, pic_busy() tells if the link is in use.
+ *  Binary frames (see FRAME_SYNC) are sent by pic_submit_frame(). A response starting with
+ *  FRAME_SYNC is assembled as binary frame and its CRC is checked before the callback
+ *  receives the raw frame (SYNC, TYPE, LEN, DATA).
+ *  Unsolicited status frames (FRAME_STATUS_PUSH) may arrive at any time, also while no
+ *  transaction is open or before the response of the open one. They are passed to the
+ *  callback registered by pic_subscribe() and don't complete the open transaction.
+ *  A corrupted frame fails only an open frame transaction, during an ASCII transaction
+ *  (p.e. a pushed frame hit by noise) it is dropped and the ASCII response is awaited.
+ *  The baud rate is negotiated by a state machine (pic_baud_start(), pic_baud_poll()), which
+ *  uses the transport like any other command and never waits (PIC firmware and bootloader).
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue (replaces the busy waiting cmd2pic() in ESP-ValveControl.ino)
+ *  - Added binary frames with CRC-16 (pic_submit_frame())
+ *  - Added receive path for unsolicited status frames (pic_subscribe())
+ *  - Added baud rate negotiation (pic_baud_negotiate())
+ *  - Baud rate negotiation by a state machine (pic_baud_start(), pic_baud_poll()), job 'link'
+ *    is no longer blocked. pic_baud_negotiate() remains as blocking wrapper (firmware download).
+ *  - Transport errors PIC_E_TIMEOUT, PIC_E_FRAME, PIC_E_BUSY outside the PIC error numbers
+ */
+
+// *** data type, constant and macro definitions
+#define FRAME_TIMEOUT   20    /* [ms] max. time to receive a complete frame (17 bytes: 4.4 ms) */
+#define PIC_VERIFY_MS   500   /* [ms] PIC falls back to PIC_BAUD, unless a new rate is confirmed within */
+
+/// States of the PIC transport
+enum PICstates
+{
+  PIC_IDLE = 0,   //!< no transaction open
+  PIC_WAIT,       //!< command sent, waiting for the response
+};
+
+/// States of the baud rate negotiation (pic_baud_poll())
+enum BAUDstates
+{
+  BAUD_IDLE = 0,  //!< no negotiation in progress
+  BAUD_REQUEST,   //!< send "Baud:<rate>" at PIC_BAUD
+  BAUD_WAIT,      //!< waiting for a response (pic_baud_onRequest(), pic_baud_onVerify())
+  BAUD_SWITCH,    //!< switched to the new rate, send the test after BAUD_SWITCH_MS
+  BAUD_FALLBACK,  //!< test failed, wait until the PIC has fallen back to PIC_BAUD
+};
+#define BAUD_SWITCH_MS  10    /* [ms] the PIC switches after its response */
+
+// *** global variables
+// *** private variables
+static uint8_t        pic_state = PIC_IDLE;   // transport state
+static pic_callback_t pic_callback = NULL;    // completion callback of open transaction
+static unsigned long  pic_tstart;             // time stamp of command transmission
+static int            pic_error;              // result of last blocking cmd2pic()
+static bool           pic_binary;             // response is a binary frame
+static bool           pic_frame_open;         // open transaction was sent as binary frame
+static unsigned long  pic_trx;                // time stamp of the SYNC byte of a frame
+static pic_callback_t pic_push_callback = NULL; // callback of unsolicited frames
+static const long     pic_bauds[] = { 500000, 250000, 115200 }; // tried from the highest (PIC: error < 1 %)
+static uint8_t        baud_state = BAUD_IDLE; // state of the baud rate negotiation
+static uint8_t        baud_ix;                // rate tried (index of pic_bauds[])
+static long           baud_max;               // [Bd] max. rate to negotiate
+static bool           baud_retry;             // request repeated after a timeout
+static unsigned long  baud_t;                 // [ms] time of the switch / fallback
+static char           baud_cmd[16];           // "Baud:<rate>" (request and test)
+
+// *** private function prototypes
+static void  pic_complete (int error);
+static void  pic_cmd2pic_done (int error, const char *response);
+static void  pic_start (void);
+static void  pic_rxreset (void);
+static int   pic_frame_check (void);
+static uint16_t pic_crc16 (uint16_t crc, uint8_t data);
+static void  pic_baud_next (void);
+static void  pic_baud_onRequest (int error, const char *response);
+static void  pic_baud_onVerify (int error, const char *response);
+
+// *** public function bodies
+
+/** @brief  Starts a new transaction: sends the command string via UART to the PIC µC.
+ *  @param  char *cmd            Command string (without line terminator)
+ *  @param  pic_callback_t done  Completion callback (may be NULL)
+ *  @return int error  0: command sent
+ *                    -1: transport busy (command not sent)
+ */
+int pic_submit (const char *cmd, pic_callback_t done)
+{
+  if (pic_state != PIC_IDLE) return (-1);
+
+  if (cmd != txbuf)
+  {
+    strncpy(txbuf, cmd, sizeof(txbuf));
+    txbuf[sizeof(txbuf) - 1] = '\0';
+  }
+
+  pic_start();
+  Serial.println(txbuf);  // transmit query to PIC µC
+  pic_callback = done;
+  pic_frame_open = false;
+
+  return (0);
+
+} // pic_submit ()
+
+
+/** @brief  Starts a new transaction: sends a binary frame to the PIC µC.
+ *  @param  uint8_t type         Frame type (FRAME_xxx)
+ *  @param  uint8_t *data        Payload (may be NULL if len == 0)
+ *  @param  uint8_t len          Number of payload bytes [0 .. FRAME_MAXDATA]
+ *  @param  pic_callback_t done  Completion callback (may be NULL)
+ *  @return int error  0: frame sent
+ *                    -1: transport busy or invalid length (frame not sent)
+ */
+int pic_submit_frame (uint8_t type, const uint8_t *data, uint8_t len, pic_callback_t done)
+{
+  uint8_t   frame[FRAME_MAXDATA + FRAME_OVERHEAD];
+  uint16_t  crc = 0xFFFF;
+
+  if ((pic_state != PIC_IDLE) || (len > FRAME_MAXDATA)) return (-1);
+
+  frame[0] = FRAME_SYNC;
+  frame[1] = type;
+  frame[2] = len;
+  if (len) memcpy(&frame[3], data, len);
+  for (int i = 1; i < len + 3; i++) crc = pic_crc16(crc, frame[i]);
+  frame[len + 3] = (uint8_t) crc;
+  frame[len + 4] = (uint8_t) (crc >> 8);
+
+  pic_start();
+  Serial.write(frame, len + FRAME_OVERHEAD);
+  pic_callback = done;
+  pic_frame_open = true;
+
+  return (0);
+
+} // pic_submit_frame ()
+
+
+/** @brief  Registers the callback for unsolicited status frames (FRAME_STATUS_PUSH).
+ *  The callback receives the raw frame like the completion callback of a FRAME_STATUS_REQ.
+ */
+void pic_subscribe (pic_callback_t callback)
+{
+  pic_push_callback = callback;
+
+} // pic_subscribe ()
+
+
+/** @brief  Returns true while a transaction is open.
+ */
+bool pic_busy (void)
+{
+  return (pic_state != PIC_IDLE);
+
+} // pic_busy ()
+
+
+/** @brief  Assembles the response of the open transaction from the received chars
+ *  and dispatches unsolicited frames.
+ *  Never waits: processes the chars available in the UART FIFO, checks the timeouts
+ *  and returns. Call this function from loop() as often as possible, also while no
+ *  transaction is open. ASCII chars received without open transaction are discarded.
+ */
+void pic_poll (void)
+{
+  char      c;
+  int       error;
+
+  while (Serial.available() > 0)
+  {
+    c = Serial.read();
+    if ((nrx == 0) && ((uint8_t) c == FRAME_SYNC))
+    {
+      pic_binary = true;
+      pic_trx = millis();
+    }
+    if (pic_binary)
+    { // binary frame: SYNC, TYPE, LEN, DATA[LEN], CRC low, CRC high
+      rxbuf[nrx++] = c;
+      error = pic_frame_check();
+      if (error > 0) continue;      // incomplete
+      if (!error && ((uint8_t) rxbuf[1] == FRAME_STATUS_PUSH))
+      {
+        if (pic_push_callback) pic_push_callback(0, rxbuf);
+        pic_rxreset();
+        continue;                   // (the open transaction is still waiting)
+      }
+      if ((pic_state == PIC_IDLE) || (error && !pic_frame_open))
+      {
+        pic_rxreset();              // stale or corrupted frame (an ASCII response is still due)
+        continue;
+      }
+      if (!error && ((uint8_t) rxbuf[1] == FRAME_ERROR))
+      {
+        error = (int8_t) rxbuf[3];  // error number from PIC (negative)
+      }
+      pic_complete(error);
+      return;
+    } // binary frame
+    if (pic_state == PIC_IDLE) continue;  // discard stale ASCII input
+    if (c == '\r') continue;  // skip
+    if (c == '\n')
+    {
+      if (nrx < 2)  continue;
+      rxbuf[(nrx < sizeof(rxbuf)) ? nrx : sizeof(rxbuf) - 1] = '\0';
+      pic_complete(0);
+      return;
+    }
+    if (nrx < sizeof(rxbuf) - 1)  // if not buffer overflow
+    {
+      rxbuf[nrx++] = c;           // store received char in rxbuf, increment count
+      rxbuf[nrx] = '\0';
+    }
+  } // while
+
+  if (pic_binary && ((millis() - pic_trx) > FRAME_TIMEOUT))
+  {
+    if ((pic_state == PIC_IDLE) || !pic_frame_open) pic_rxreset();   // incomplete frame: discard
+    else pic_complete(PIC_E_FRAME);
+  }
+  else if ((pic_state != PIC_IDLE) && ((millis() - pic_tstart) > MAX_ACK_TIME))
+  {
+    pic_complete(PIC_E_TIMEOUT);
+  }
+
+} // pic_poll ()
+
+
+/** @brief  This function sends the command string in txbuf[] via UART to the PIC µC
+ *          and waits for a response or timeout.
+ *          The response is returned in global rxbuf[].
+ *  @note   Only to be used for bulk transfers (firmware download, log data), where the
+ *          caller has to wait anyway. Does not process any web requests during the wait.
+ *  @return int error  0: no error
+ *                    PIC_E_BUSY: transport busy
+ *                    PIC_E_TIMEOUT: timeout
+ *                    PIC_E_FRAME: binary frame with invalid length or CRC
+ *                    <0: error number from PIC ("ERROR nn")
+*/
+int cmd2pic (void)
+{
+  while (pic_busy())  // finish a pending transaction first
+  {
+    pic_poll();
+    yield();
+  }
+
+  pic_error = PIC_E_BUSY;
+  if (pic_submit(txbuf, pic_cmd2pic_done) == 0)
+  {
+    while (pic_busy())
+    {
+      pic_poll();
+      yield();
+    }
+  }
+  return (pic_error);
+
+} // cmd2pic ()
+
+
+/** @brief  Starts the negotiation of the highest baud rate (up to max) with the PIC µC, firmware
+ *  or bootloader. Starts at PIC_BAUD. For each rate "Baud:<rate>" is sent at PIC_BAUD; after the
+ *  response both sides switch and the ESP sends the same command at the new rate as test. If the
+ *  test fails, both sides fall back to PIC_BAUD (the PIC after PIC_VERIFY_MS) and the next lower
+ *  rate is tried. An error response other than E_BAUD (older PIC firmware) keeps PIC_BAUD. \n
+ *  A request, that is received with framing errors by a PIC still running at a higher rate
+ *  (p.e. after an ESP restart), lets the PIC fall back to PIC_BAUD, so it is sent twice.
+ *  The steps are done by pic_baud_poll() (job 'link'), a running negotiation is not restarted.
+ *  @param  long max  [Bd] max. baud rate (ovc.ini BAUD_MAX)
+ */
+void pic_baud_start (long max)
+{
+  if (baud_state != BAUD_IDLE) return;
+
+  pic_set_baud(PIC_BAUD);
+  baud_max = max;
+  baud_ix = 0;
+  baud_retry = false;
+  baud_state = BAUD_REQUEST;
+
+} // pic_baud_start ()
+
+
+/** @brief  Returns true while the baud rate is negotiated (no other command may be sent).
+ */
+bool pic_baud_busy (void)
+{
+  return (baud_state != BAUD_IDLE);
+
+} // pic_baud_busy ()
+
+
+/** @brief  Next step of the baud rate negotiation. Never waits: call while the transport is
+ *  idle (job 'link'), the responses are handled by the completion callbacks.
+ */
+void pic_baud_poll (void)
+{
+  switch (baud_state)
+  {
+    case BAUD_REQUEST:
+      while ((baud_ix < sizeof(pic_bauds) / sizeof(pic_bauds[0])) && (pic_bauds[baud_ix] > baud_max)) baud_ix++;
+      if (baud_ix >= sizeof(pic_bauds) / sizeof(pic_bauds[0]))
+      {
+        baud_state = BAUD_IDLE;     // no rate left: PIC_BAUD
+        break;
+      }
+      sprintf(baud_cmd, "Baud:%ld", pic_bauds[baud_ix]);
+      baud_state = BAUD_WAIT;
+      pic_submit(baud_cmd, pic_baud_onRequest);
+      break;
+
+    case BAUD_SWITCH:
+      if ((millis() - baud_t) < BAUD_SWITCH_MS) break;
+      baud_state = BAUD_WAIT;
+      pic_submit(baud_cmd, pic_baud_onVerify);
+      break;
+
+    case BAUD_FALLBACK:
+      if ((millis() - baud_t) > PIC_VERIFY_MS + 100) pic_baud_next();
+      break;
+
+    default:
+      break;
+  }
+
+} // pic_baud_poll ()
+
+
+/** @brief  Negotiates the baud rate and waits for the result (pic_baud_start()).
+ *  @note   Blocking: only for the firmware download, which has to wait anyway.
+ *  @param  long max  [Bd] max. baud rate (ovc.ini BAUD_MAX)
+ *  @return long  negotiated baud rate
+ */
+long pic_baud_negotiate (long max)
+{
+  pic_baud_start(max);
+  while (pic_baud_busy())
+  {
+    pic_poll();
+    if (!pic_busy()) pic_baud_poll();
+    yield();
+  }
+  return (picBaud);
+
+} // pic_baud_negotiate ()
+
+
+/** @brief  Sets the baud rate of the UART to the PIC µC (after the TX FIFO has been sent).
+ *  @param  long baud  [Bd]
+ */
+void pic_set_baud (long baud)
+{
+  Serial.flush();
+  Serial.updateBaudRate(baud);
+  picBaud = baud;
+  pic_rxreset();    // (chars received meanwhile are garbage)
+
+} // pic_set_baud ()
+
+
+// *** private function bodies
+
+/** @brief  Baud rate negotiation: tries the next lower rate.
+ */
+static void pic_baud_next (void)
+{
+  baud_ix++;
+  baud_retry = false;
+  baud_state = BAUD_REQUEST;
+
+} // pic_baud_next ()
+
+
+/** @brief  Completion callback of "Baud:<rate>" at PIC_BAUD: switches to the new rate.
+ */
+static void pic_baud_onRequest (int error, const char *response)
+{
+  if ((error == PIC_E_TIMEOUT) && !baud_retry)   // (PIC has fallen back to PIC_BAUD meanwhile)
+  {
+    baud_retry = true;
+    baud_state = BAUD_REQUEST;
+  }
+  else if (error == -9) pic_baud_next();    // E_BAUD: rate not supported
+  else if (error || strcmp(response, baud_cmd)) baud_state = BAUD_IDLE;  // no baud rate negotiation
+  else
+  {
+    pic_set_baud(pic_bauds[baud_ix]);
+    baud_t = millis();
+    baud_state = BAUD_SWITCH;
+  }
+
+} // pic_baud_onRequest ()
+
+
+/** @brief  Completion callback of the test at the new rate: confirmed, or back to PIC_BAUD.
+ */
+static void pic_baud_onVerify (int error, const char *response)
+{
+  if (!error && !strcmp(response, baud_cmd))
+  {
+    baud_state = BAUD_IDLE;         // confirmed
+    return;
+  }
+  pic_set_baud(PIC_BAUD);
+  baud_t = millis();
+  baud_state = BAUD_FALLBACK;       // until the PIC has fallen back
+
+} // pic_baud_onVerify ()
+
+
+/** @brief  Opens a new transaction. Stale ASCII input has already been discarded by
+ *  pic_poll(), a partially received (unsolicited) frame is kept.
+ */
+static void pic_start (void)
+{
+  if (!pic_binary) pic_rxreset();
+  pic_tstart = millis();
+  pic_state = PIC_WAIT;
+
+} // pic_start ()
+
+
+/** @brief  Flushes rxbuf for the next response or frame.
+ */
+static void pic_rxreset (void)
+{
+  nrx = 0;
+  rxbuf[0] = '\0';
+  pic_binary = false;
+
+} // pic_rxreset ()
+
+
+/** @brief  Checks the binary frame in rxbuf[nrx].
+ *  @return int  1: incomplete, 0: complete and valid, PIC_E_FRAME: invalid length or CRC
+ */
+static int pic_frame_check (void)
+{
+  uint16_t  crc = 0xFFFF;
+
+  if (nrx < 3) return (1);
+  if ((uint8_t) rxbuf[2] > FRAME_MAXDATA) return (PIC_E_FRAME);
+  if (nrx < (uint8_t) rxbuf[2] + FRAME_OVERHEAD) return (1);
+
+  for (int i = 1; i < nrx - 2; i++) crc = pic_crc16(crc, rxbuf[i]);
+  if (((uint8_t) rxbuf[nrx - 2] != (uint8_t) crc) || ((uint8_t) rxbuf[nrx - 1] != (uint8_t) (crc >> 8)))
+  {
+    return (PIC_E_FRAME);
+  }
+  return (0);
+
+} // pic_frame_check ()
+
+
+/** @brief  Updates the CRC-16/CCITT (poly 0x1021, init 0xFFFF) by one data byte.
+ *  Same table-free algorithm as frame_crc16() of the PIC.
+ */
+static uint16_t pic_crc16 (uint16_t crc, uint8_t data)
+{
+  crc  = (crc >> 8) | (crc << 8);
+  crc ^= data;
+  crc ^= (crc & 0xFF) >> 4;
+  crc ^= crc << 12;
+  crc ^= (crc & 0xFF) << 5;
+
+  return (crc);
+
+} // pic_crc16 ()
+
+
+/** @brief  Closes the open transaction and invokes the completion callback.
+ *  @param  int error  0, PIC_E_TIMEOUT, PIC_E_FRAME or error number of FRAME_ERROR
+ */
+static void pic_complete (int error)
+{
+  pic_callback_t  done = pic_callback;
+
+  if (!error && !pic_binary && (strncmp(rxbuf, "ERROR", 5) == 0))
+  {
+    error = atoi(&rxbuf[5]);  // error number from PIC (negative)
+  }
+  pic_state = PIC_IDLE;       // allows a new submit from the callback
+  pic_callback = NULL;
+  nrx = 0;                    // ready for the next frame (rxbuf is kept for the callback)
+  pic_binary = false;
+
+  if (done) done(error, rxbuf);
+
+} // pic_complete ()
+
+
+/** @brief  Completion callback of the blocking cmd2pic().
+ */
+static void pic_cmd2pic_done (int error, const char *response)
+{
+  pic_error = error;
+
+} // pic_cmd2pic_done ()
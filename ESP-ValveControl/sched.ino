@@ -0,0 +1,166 @@
+/** @file  sched.ino
+ *  @author  (c) Klaus Deutschkämer (https://github.com/deklaus)
+ *  License: This software is licensed under the European Union Public Licence EUPL-1.2
+ *           (see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12 for details).
+ *
+ *  @brief Cooperative deadline scheduler for loop(). \n
+ *  Jobs are registered by sched_add() with a period and a deadline. sched_run() is called
+ *  from loop() and runs every due job in the order of registration (= priority).
+ *  A job which starts later than its deadline (after it became due) counts as overrun.
+ *  Passes without any due job count as idle time. The statistics are available as JSON
+ *  by sched_json() (see webUI_sched()).
+ *  Jobs must not block: a job which takes long (p.e. firmware download) delays all others
+ *  and will show up as overruns of the other jobs.
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue (replaces the fixed CYCLE_TIME loop)
+ */
+
+// *** data type, constant and macro definitions
+#define SCHED_MAXTASKS  8     /* max. number of jobs */
+
+// *** global variables
+// *** private variables
+static TASK           sched_tasks[SCHED_MAXTASKS];  // task table
+static int            sched_ntasks = 0;             // number of registered jobs
+static unsigned long  sched_tstart;                 // [ms] start of statistics
+static uint64_t       sched_idle_us;                // [µs] sum of idle passes
+static unsigned long  sched_passes;                 // number of passes
+
+// *** public function bodies
+
+/** @brief  Registers a job.
+ *  @param  char *name        Name of the job (statistics)
+ *  @param  sched_job_t job   Function to run
+ *  @param  uint32_t period   Period [ms], the first run is due immediately
+ *  @param  uint32_t deadline Max. delay [ms] after becoming due, before an overrun is counted
+ *  @return TASK *  registered task (the period may be changed at runtime), or NULL if the table is full
+ */
+TASK *sched_add (const char *name, sched_job_t job, uint32_t period, uint32_t deadline)
+{
+  TASK *task;
+
+  if (sched_ntasks >= SCHED_MAXTASKS) return (NULL);
+
+  task = &sched_tasks[sched_ntasks++];
+  memset(task, 0, sizeof(TASK));
+  task->name     = name;
+  task->job      = job;
+  task->period   = period;
+  task->deadline = deadline;
+  task->due      = millis();
+
+  sched_tstart = millis();
+
+  return (task);
+
+} // sched_add ()
+
+
+/** @brief  Runs all due jobs once. Call this function from loop().
+ */
+void sched_run (void)
+{
+  TASK          *task;
+  unsigned long  now;
+  unsigned long  t0, dt;
+  long           late;
+  bool           idle = true;
+
+  t0 = micros();
+  sched_passes++;
+
+  for (int i = 0; i < sched_ntasks; i++)
+  {
+    task = &sched_tasks[i];
+    now  = millis();
+    late = (long)(now - task->due);
+    if (late < 0) continue;           // not yet due
+
+    if ((uint32_t) late > task->deadline) task->overruns++;
+    if ((uint32_t) late > task->late_max) task->late_max = late;
+
+    // next due time: keep the phase, but don't try to catch up missed periods
+    task->due += task->period;
+    if ((long)(now - task->due) >= 0) task->due = now + task->period;
+
+    dt = micros();
+    task->job();
+    dt = micros() - dt;
+
+    task->runs++;
+    task->t_sum += dt;
+    if (dt > task->t_max) task->t_max = dt;
+    idle = false;
+  }
+
+  if (idle) sched_idle_us += micros() - t0;
+
+} // sched_run ()
+
+
+/** @brief  Makes a job due immediately (p.e. when its input has changed).
+ */
+void sched_trigger (TASK *task)
+{
+  if (task) task->due = millis();
+
+} // sched_trigger ()
+
+
+/** @brief  Changes the period of a job. A shorter period takes effect immediately
+ *  (the job is due not later than now + period), a longer one after the next run.
+ */
+void sched_set_period (TASK *task, uint32_t period)
+{
+  unsigned long now = millis();
+
+  if (!task || (task->period == period)) return;
+
+  if ((long)(task->due - (now + period)) > 0) task->due = now + period;
+  task->period = period;
+
+} // sched_set_period ()
+
+
+/** @brief  Writes the scheduler statistics as JSON into dest[len] and resets them, e.g.
+ *  { "idle": 92.5, "passes": 81234, "tasks": [ { "name": "link", "period": 1, "runs": 9996,
+ *    "overruns": 0, "late_max": 2, "t_avg": 41, "t_max": 5230 }, ... ] }
+ *  Tasks (in order of registration): link, status, events, display, sensor, mqtt.
+ *  Times in ms (period, late_max) and µs (t_avg, t_max), idle in % of the elapsed time.
+ */
+void sched_json (char *dest, int len)
+{
+  TASK          *task;
+  unsigned long  elapsed = millis() - sched_tstart;   // [ms]
+  int            n;
+
+  n = snprintf(dest, len, "{ \"idle\": %.1f, \"passes\": %lu, \"tasks\": [",
+                elapsed ? 0.1 * sched_idle_us / elapsed : 0.0, sched_passes);
+
+  for (int i = 0; (i < sched_ntasks) && (n < len); i++)
+  {
+    task = &sched_tasks[i];
+    n += snprintf(&dest[n], len - n, "%s\n  { \"name\": \"%s\", \"period\": %lu, \"runs\": %lu, "
+                  "\"overruns\": %lu, \"late_max\": %lu, \"t_avg\": %lu, \"t_max\": %lu }",
+                  i ? "," : "", task->name, (unsigned long) task->period, (unsigned long) task->runs,
+                  (unsigned long) task->overruns, (unsigned long) task->late_max,
+                  (unsigned long) (task->runs ? task->t_sum / task->runs : 0), (unsigned long) task->t_max);
+
+    task->runs = task->overruns = task->late_max = task->t_max = 0;   // reset statistics
+    task->t_sum = 0;
+  }
+  if (n < len) snprintf(&dest[n], len - n, " ]\n}\n");
+
+  sched_tstart  = millis();
+  sched_idle_us = 0;
+  sched_passes  = 0;
+
+} // sched_json ()
+
+// *** private function bodies
+
+/**
+ End of File
+ */
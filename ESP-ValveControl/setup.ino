@@ -10,6 +10,12 @@
 /*  Change Log:
  *  2023-11-15
  *  - First issue
+ *  2026-10-16 v0.9
+ *  - Added POLL_FAST and POLL_IDLE (period of PIC status requests).
+ *  - Added MOVE_WINDOW (coalescing window of MOVE commands).
+ *  - Added BUDGET_MA and CONCURRENT (concurrent moves).
+ *  - Added BAUD_MAX (max. baud rate of the PIC link).
+ *  - Added PIC_<NAME> (PIC parameter table, see paramName[]).
  */
 
 /** @brief  Reads one char array from ini File (in LittleFS)
@@ -201,6 +207,7 @@ int setup_ReadINI (const char *path)
 {
   int error = 0;
   int ivalue;
+  float fvalue;
 
   error += setup_GetCstring(path, "SSID", ssid, sizeof(ssid));
   error += setup_GetCstring(path, "PSK",  psk, sizeof(psk));
@@ -218,6 +225,36 @@ int setup_ReadINI (const char *path)
   
   error += setup_GetFloat(path, "dTemp",  &dTemp);
 
+  ivalue = 0; // set default (if not found)
+  error += setup_GetInt(path, "POLL_FAST", &ivalue);
+  if ((ivalue >= 50) && (ivalue <= 1000)) pollFast = ivalue;
+  ivalue = 0;
+  error += setup_GetInt(path, "POLL_IDLE", &ivalue);
+  if ((ivalue >= 500) && (ivalue <= 60000)) pollIdle = ivalue;
+  ivalue = -1;
+  error += setup_GetInt(path, "MOVE_WINDOW", &ivalue);
+  if ((ivalue >= 0) && (ivalue <= 5000)) moveWindow = ivalue;
+  ivalue = 0;
+  error += setup_GetInt(path, "CONCURRENT", &ivalue);
+  if ((ivalue >= 1) && (ivalue <= numVZ)) concurrent = ivalue;
+  fvalue = 0.;
+  error += setup_GetFloat(path, "BUDGET_MA", &fvalue);
+  if ((fvalue >= 1.) && (fvalue <= 800.)) budget_mA = fvalue;
+  ivalue = 0;
+  error += setup_GetInt(path, "BAUD_MAX", &ivalue);
+  if ((ivalue >= PIC_BAUD) && (ivalue <= 500000)) baudMax = ivalue;
+
+  for (int i = 0; i < NUM_PARAM; i++)   // PIC parameters, p.e. PIC_DUTY_MAX (range checked by the PIC)
+  {
+    char  key[24];
+
+    snprintf(key, sizeof(key), "PIC_%s", paramName[i]);
+    for (char *p = key; *p; p++) *p = toupper(*p);
+    ivalue = -1;
+    error += setup_GetInt(path, key, &ivalue);
+    if ((ivalue >= 0) && (ivalue <= 0xFFFF)) paramIni[i] = ivalue;
+  }
+
   return(error);
 
 } // setup_ReadINI ()
@@ -0,0 +1,155 @@
+/** @file  status.ino
+ *  @author  (c) Klaus Deutschkämer (https://github.com/deklaus)
+ *  License: This software is licensed under the European Union Public Licence EUPL-1.2
+ *           (see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12 for details).
+ *
+ *  @brief Versioned status snapshot for <IP>/status. \n
+ *  status_update() compares the status values (current, temperature, positions, set positions,
+ *  reference flags and current limits) with the snapshot. On any change the snapshot version is
+ *  incremented, each changed field is stamped with the new version and the JSON document is
+ *  serialized once into a cache. Requests are answered from the cache (ETag = version), unchanged
+ *  polls get HTTP 304, and status_delta() returns only the fields changed since a given version.
+ *  Each change triggers job_events(), which pushes the changed fields to the Web UI.
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ */
+
+// *** data type, constant and macro definitions
+
+/// Fields of the snapshot (index of stat_val[], stat_ver[])
+enum STATfields
+{
+  ST_MAMPS = 0,   //!< mAmps x 10
+  ST_TEMPC,       //!< tempC x 10
+  ST_VZ,          //!< first field of VZ1, each VZ has ST_VZFIELDS fields (see stat_names[])
+};
+#define ST_VZFIELDS   4                             /* Position, Set_Pos, Ref_Set, max_mA x 10 */
+#define ST_NFIELDS    (ST_VZ + ST_VZFIELDS * numVZ)
+
+// *** global variables
+// *** private variables
+static int32_t      stat_val[ST_NFIELDS];   // values of the snapshot
+static uint32_t     stat_ver[ST_NFIELDS];   // version of the last change of each field
+static uint32_t     stat_version = 0;       // version of the snapshot (0: not yet created)
+static char         stat_json[512];         // cached (pretty) JSON document of the snapshot
+static const char  *stat_names[ST_VZFIELDS] = { "Position", "Set_Pos", "Ref_Set", "max_mA" };
+
+// *** private function prototypes
+static void  status_values (int32_t *val);
+
+// *** public function bodies
+
+/** @brief  Updates the snapshot from the current status values. Cheap if nothing has changed,
+ *  the JSON document is serialized only on change. Call after every change of the values.
+ *  @return bool  true: snapshot has changed (new version)
+ */
+bool status_update (void)
+{
+  int32_t   val[ST_NFIELDS];
+  bool      changed = false;
+
+  status_values(val);
+  for (int i = 0; i < ST_NFIELDS; i++)
+  {
+    if ((stat_version == 0) || (val[i] != stat_val[i]))
+    {
+      if (!changed) stat_version++;
+      changed = true;
+      stat_val[i] = val[i];
+      stat_ver[i] = stat_version;
+    }
+  }
+  if (changed)
+  {
+    create_jStatus(stat_json, sizeof(stat_json), true);  // serialize once per change
+    sched_trigger(task_events);                           // push to the subscribers (events.ino)
+  }
+
+  return (changed);
+
+} // status_update ()
+
+
+/** @brief  Returns the version of the snapshot (incremented on every change).
+ */
+uint32_t status_version (void)
+{
+  return (stat_version);
+
+} // status_version ()
+
+
+/** @brief  Returns the cached JSON document of the snapshot (see create_jStatus()).
+ */
+const char *status_json (void)
+{
+  return (stat_json);
+
+} // status_json ()
+
+
+/** @brief  Writes the fields changed since version 'since' as JSON into dest[len], p.e.
+ *  { "version": 18, "mAmps": 12.3, "VZ2": { "Position": 47 } }
+ *  @param  uint32_t since  version known by the client
+ */
+void status_delta (uint32_t since, char *dest, int len)
+{
+  int   n;
+  int   ix;
+  bool  open;
+
+  n = snprintf(dest, len, "{\n  \"version\": %lu", (unsigned long) stat_version);
+  if ((stat_ver[ST_MAMPS] > since) && (n < len))
+  {
+    n += snprintf(&dest[n], len - n, ",\n  \"mAmps\": %.1f", stat_val[ST_MAMPS] / 10.0);
+  }
+  if ((stat_ver[ST_TEMPC] > since) && (n < len))
+  {
+    n += snprintf(&dest[n], len - n, ",\n  \"tempC\": %.1f", stat_val[ST_TEMPC] / 10.0);
+  }
+  for (int vz = 1; vz <= numVZ; vz++)
+  {
+    open = false;
+    for (int f = 0; (f < ST_VZFIELDS) && (n < len); f++)
+    {
+      ix = ST_VZ + ST_VZFIELDS * (vz - 1) + f;
+      if (stat_ver[ix] <= since) continue;
+      if (!open) n += snprintf(&dest[n], len - n, ",\n  \"VZ%d\": { ", vz);
+      else       n += snprintf(&dest[n], len - n, ", ");
+      open = true;
+      if (n >= len) break;
+      if (f == 3) n += snprintf(&dest[n], len - n, "\"%s\": %.1f", stat_names[f], stat_val[ix] / 10.0);
+      else        n += snprintf(&dest[n], len - n, "\"%s\": %ld", stat_names[f], (long) stat_val[ix]);
+    }
+    if (open && (n < len)) n += snprintf(&dest[n], len - n, " }");
+  }
+  if (n < len) snprintf(&dest[n], len - n, "\n}\n");
+
+} // status_delta ()
+
+// *** private function bodies
+
+/** @brief  Reads the status values in the resolution of the JSON document (0.1 mA, 0.1 °C).
+ */
+static void status_values (int32_t *val)
+{
+  int32_t  *v;
+
+  val[ST_MAMPS] = lround(mAmps * 10);
+  val[ST_TEMPC] = lround(tempC * 10);
+  for (int vz = 1; vz <= numVZ; vz++)
+  {
+    v = &val[ST_VZ + ST_VZFIELDS * (vz - 1)];
+    v[0] = position[vz];
+    v[1] = set_pos[vz];
+    v[2] = refset[vz] ? 1 : 0;
+    v[3] = lround(max_mA[vz] * 10);
+  }
+
+} // status_values ()
+
+/**
+ End of File
+ */
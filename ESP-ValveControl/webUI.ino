@@ -6,6 +6,19 @@
  *  @brief Functions for WiFi User Interface (UI)
  */
 /*  Change Log:
+ *  2026-10-16 v0.9
+ *  - Move, home, logdata, bootload and info append commands to the command queue (cmdq.ino)
+ *    and return the id of the command ("id=nn"). HTTP 503 if the queue is full.
+ *  - Added webUI_queue: <IP>/queue lists the queued commands, <IP>/queue?id=nn shows one.
+ *  - Added webUI_sched: <IP>/sched shows the scheduler statistics (since the last request).
+ *  - webUI_status serves the cached status snapshot (status.ino) with ETag, HTTP 304 if unchanged,
+ *    and the changed fields only for <IP>/status?since=<version>.
+ *  - Request handlers for ESPAsyncWebServer (AsyncWebServerRequest), they run in the TCP
+ *    callbacks and must not wait: PIC commands are queued, save & reboot is done by loop().
+ *  - Added webUI_update: OTA update of the ESP firmware (replaces ESP8266HTTPUpdateServer).
+ *  - Added webUI_api_move: POST <IP>/api/move moves several zones by one queued command.
+ *  - Added webUI_calib: <IP>/calib queues a calibration run (learns the stroke time of a zone).
+ *  - Added webUI_param: <IP>/param reads, <IP>/param?<name>=<value> sets a PIC parameter.
  *  2023-11-23 v0.6
  *  - Added webUI_bootload. Essentially displays a notification and sets "flags.bootload",
  *    which then is processed in the main loop.
@@ -17,6 +30,7 @@
  *  Weblinks: 
  *  https://links2004.github.io/Arduino/d3/d58/class_e_s_p8266_web_server.html
  *  https://github.com/esp8266/Arduino/tree/master/libraries/ESP8266WebServer
+ *  https://github.com/me-no-dev/ESPAsyncWebServer
  *  https://arduino-esp8266.readthedocs.io/en/latest/filesystem.html
  */
 
@@ -30,70 +44,81 @@
  *  @param  char *path  Filename (must start with "/" and end with .hex)
  *  @return int  error
 */
-void webUI_bootload (void)
+void webUI_bootload (AsyncWebServerRequest *request)
 {
   int     error = 0;
+  int     id;
   String  str;
   String  htmlPage;
   htmlPage.reserve(128);  // prevent ram fragmentation
 
   htmlPage  = F("Update of PIC Firmware\n");
 
-  if (server.hasArg("hexfile"))
+  if (request->hasArg("hexfile"))
   {
-    str = server.arg("hexfile");
+    str = request->arg("hexfile");
     str.toCharArray(hexfilename, sizeof(hexfilename));
     htmlPage += F("with hexfile: "); htmlPage += hexfilename; htmlPage += F("\n");
 
     if (!LittleFS.exists(hexfilename))
     {
       htmlPage += F("File doesn't exist! \n");
-      for (uint8_t i = 0; i < server.args(); i++) 
+      for (uint8_t i = 0; i < request->args(); i++) 
       {
-        htmlPage += server.argName(i) + "=" + server.arg(i) + "\n";
+        htmlPage += request->argName(i) + "=" + request->arg(i) + "\n";
       }
     }
+    else if ((id = cmdq_push(CMD_BOOTLOAD, 0, 0, 0)) < 0)
+    {
+      htmlPage += F("Command queue full!\n");
+      error = 503;
+    }
     else
     {
       htmlPage += "Starting bootloader - please wait for completion\n";
       htmlPage += "(check OLED display for status).\n";
-      flags.bootload = 1;
+      htmlPage += F("id="); htmlPage += id; htmlPage += F("\n");
     }    
   }
   else
   {
     htmlPage += F("Usage: <ip>/bootload?hexfile=filename.hex\n");
   }
-  server.send(200, "text/plain", htmlPage);
+  request->send(error ? error : 200, "text/plain", htmlPage);
 
 } // webUI_bootload ()
 
 
 /** @brief Handler for logdata request.
  */
-void webUI_logdata ()
+void webUI_logdata (AsyncWebServerRequest *request)
 {
   char  buf[128];
+  int   id;
   String htmlPage;
   htmlPage.reserve(128);  // prevent ram fragmentation
 
+  id = cmdq_push(CMD_LOGDATA, 0, 0, 0);
+  if (id < 0)
+  {
+    request->send(503, "text/plain", "Command queue full!\n");
+    return;
+  }
+
   htmlPage = F("Requesting LogData from PIC Controller...\n");
   htmlPage += "Please allow approx. 5 seconds for completion,\n";
   htmlPage += "then read file 'logdata.csv' from LittleFS.\n";
-
-  server.send(200, "text/plain", htmlPage);
+  htmlPage += F("id="); htmlPage += id; htmlPage += F("\n");
 
   //server.sendHeader("Access-Control-Allow-Origin","*"); 
-  server.send(200, "text/plain", htmlPage);
-
-  flags.logdata = 1;
+  request->send(200, "text/plain", htmlPage);
 
 } // webUI_logdata ()
 
 
 /** @brief Handler for MOVE. Arguments: <ESP_IP>/move?vz=[1..4]&set_pos=[0..100]&max_mA=[0.0 .. 100.0]
  */
-void webUI_move ()
+void webUI_move (AsyncWebServerRequest *request)
 {
   int error = 1;  // preset!
   char  buf[64];
@@ -101,85 +126,250 @@ void webUI_move ()
   htmlPage.reserve(128);  // prevent ram fragmentation
   int   sel;
   int   pos;
+  int   id;
   float mA;
 
-  if (server.hasArg("vz") && server.hasArg("set_pos") && server.hasArg("max_mA")) 
+  if (request->hasArg("vz") && request->hasArg("set_pos") && request->hasArg("max_mA")) 
   {
-    sel = server.arg("vz").toInt();
-    pos = server.arg("set_pos").toInt();
-    mA  = server.arg("max_mA").toFloat();
+    sel = request->arg("vz").toInt();
+    pos = request->arg("set_pos").toInt();
+    mA  = request->arg("max_mA").toFloat();
     if (sel >= 1 && sel <= 4 && pos >= 0 && pos <= 100 && mA >= 0.0 && mA <= 100.) 
     {
+      id = cmdq_push(CMD_MOVE, sel, pos, (uint16_t)(10 * mA));   // queue a MOVE command to PIC
+      if (id < 0)
+      {
+        request->send(503, "text/plain", "Command queue full!\n");
+        return;
+      }
       htmlPage  = F("/move?vz="); htmlPage += sel;  
       htmlPage += F("&set_pos=");     htmlPage += pos;  
       htmlPage += F("&max_mA=");
       sprintf(buf, "%.1f", mA);       htmlPage += buf;
+      htmlPage += F("&id=");          htmlPage += id;
       htmlPage += F("\n");
 
-      vz = sel;
       set_pos[sel] = pos;
       max_mA[sel] = mA;
-      flags.move = 1;   // set flag for triggering a MOVE command to PIC
+      status_update();
       error = 0;
     }
   }
   if (error) 
   {
     htmlPage = F("Parameter error: \n");
-    for (uint8_t i = 0; i < server.args(); i++) 
+    for (uint8_t i = 0; i < request->args(); i++) 
     {
-      htmlPage += server.argName(i) + "=" + server.arg(i) + "\n";
+      htmlPage += request->argName(i) + "=" + request->arg(i) + "\n";
     }
   }    
-  server.send(200, "text/plain", htmlPage);
+  request->send(200, "text/plain", htmlPage);
 
 } // webUI_move()
 
 
-/** @brief Handler for HOME. Arguments: <ESP_IP>/home?vz=[1..4]&max_mA=[0.0 .. 100.0]
+/** @brief Handler for the batch MOVE: POST <ESP_IP>/api/move, Content-Type: application/json
+ *  Body: [ { "vz": 1, "set_pos": 25, "max_mA": 30.0 }, { "vz": 3, "set_pos": 60, "max_mA": 30.0 } ]
+ *  All entries are checked first (HTTP 400 on any error), then all zones are queued as one
+ *  MOVE command. Response: { "id": 17, "zones": 5 } (zones as bit pattern, bit 0 = vz1).
  */
-void webUI_home ()
+void webUI_api_move (AsyncWebServerRequest *request, JsonVariant &json)
+{
+  JsonArray moves = json.as<JsonArray>();
+  uint8_t   zones = 0;
+  uint8_t   pos[numVZ + 1];
+  uint16_t  mAx10[numVZ + 1];
+  float     mA[numVZ + 1];
+  char      buf[48];
+  int       sel;
+  int       val;
+  int       id;
+
+  if (moves.isNull() || (moves.size() == 0) || (moves.size() > numVZ))
+  {
+    request->send(400, "text/plain", "Parameter error: array of 1..4 zones expected\n");
+    return;
+  }
+  for (JsonObject move : moves)
+  {
+    sel = move["vz"] | 0;
+    if ((sel < 1) || (sel > numVZ) || (zones & (1 << (sel - 1))) ||
+        !move["set_pos"].is<int>() || !move["max_mA"].is<float>())
+    {
+      request->send(400, "text/plain", "Parameter error: vz, set_pos or max_mA\n");
+      return;
+    }
+    val = move["set_pos"].as<int>();
+    mA[sel] = move["max_mA"].as<float>();
+    if ((val < 0) || (val > 100) || (mA[sel] < 0.1) || (mA[sel] > 100.))
+    {
+      request->send(400, "text/plain", "Parameter error: set_pos [0..100], max_mA [0.1 .. 100.0]\n");
+      return;
+    }
+    pos[sel] = val;
+    mAx10[sel] = (uint16_t) lround(10 * mA[sel]);
+    zones |= (1 << (sel - 1));
+  }
+
+  id = cmdq_push_moves(zones, pos, mAx10);   // queue one MOVE command for all zones
+  if (id < 0)
+  {
+    request->send(503, "text/plain", "Command queue full!\n");
+    return;
+  }
+  for (sel = 1; sel <= numVZ; sel++)
+  {
+    if (!(zones & (1 << (sel - 1)))) continue;
+    set_pos[sel] = pos[sel];
+    max_mA[sel] = mA[sel];
+  }
+  status_update();
+
+  snprintf(buf, sizeof(buf), "{ \"id\": %d, \"zones\": %u }\n", id, zones);
+  request->send(200, "application/json", buf);
+
+} // webUI_api_move ()
+
+
+/** @brief Handler for HOME. Arguments: <ESP_IP>/home?vz=[0..4]&max_mA=[0.0 .. 100.0]
+ *  vz = 0: home all zones ("HomeAll:"), then the PIC moves all zones back to its set positions
+ *  (kept in its EEPROM), it runs them from its job queue one after the other.
+ */
+void webUI_home (AsyncWebServerRequest *request)
 {
   int error = 1;  // preset!
   char  buf[128];
   String htmlPage;
   htmlPage.reserve(128);  // prevent ram fragmentation
   int   sel;
+  int   id;
   float mA;
+  float mA_move;
 
-  if (server.hasArg("vz") && server.hasArg("max_mA")) 
+  if (request->hasArg("vz") && request->hasArg("max_mA")) 
   {
-    sel = server.arg("vz").toInt();
-    mA  = server.arg("max_mA").toFloat();
-    if (sel >= 1 && sel <= 4 && mA >= 0. && mA <= 100.) 
+    sel = request->arg("vz").toInt();
+    mA  = request->arg("max_mA").toFloat();
+    if (sel >= 0 && sel <= 4 && mA >= 0. && mA <= 100.) 
     {
+      if (sel) id = cmdq_push(CMD_HOME, sel, 0, (uint16_t)(10 * mA));   // queue a HOME command to PIC
+      else
+      { // all zones: "HomeAll:<mAx10>,<mAx10 move>", the move back with the highest max_mA
+        mA_move = mA;
+        for (int vz = 1; vz <= numVZ; vz++) if (max_mA[vz] > mA_move) mA_move = max_mA[vz];
+        id = cmdq_push_args(CMD_HOME, (uint16_t)(10 * mA), (uint16_t)(10 * mA_move));
+      }
+      if (id < 0)
+      {
+        request->send(503, "text/plain", "Command queue full!\n");
+        return;
+      }
       htmlPage  = F("/home?vz="); htmlPage += sel;  
       htmlPage += F("&max_mA=");
       sprintf(buf, "%.1f", mA);   htmlPage += buf;
+      htmlPage += F("&id=");      htmlPage += id;
       htmlPage += F("\n");
 
-      vz = sel;
-      max_mA[sel] = mA;
-      flags.home = 1;   // set flag for triggering a HOME command to PIC
+      if (sel) max_mA[sel] = mA;
+      status_update();
       error = 0;
     }
   }
   if (error) 
   {
     htmlPage = F("Parameter error: \n");
-    for (uint8_t i = 0; i < server.args(); i++) 
+    for (uint8_t i = 0; i < request->args(); i++) 
     {
-       htmlPage += server.argName(i) + "=" + server.arg(i) + "\n";
+       htmlPage += request->argName(i) + "=" + request->arg(i) + "\n";
     }    
   }
-  server.send(200, "text/plain", htmlPage);
+  request->send(200, "text/plain", htmlPage);
 
 } // webUI_home ()
 
 
+/** @brief Handler for CALIB (calibration run: closed - open - closed end stop). 
+ *  Arguments: <ESP_IP>/calib?vz=[1..4]&max_mA=[0.1 .. 100.0]
+ */
+void webUI_calib (AsyncWebServerRequest *request)
+{
+  char  buf[64];
+  int   sel;
+  int   id;
+  float mA;
+
+  if (request->hasArg("vz") && request->hasArg("max_mA")) 
+  {
+    sel = request->arg("vz").toInt();
+    mA  = request->arg("max_mA").toFloat();
+    if (sel >= 1 && sel <= 4 && mA > 0. && mA <= 100.) 
+    {
+      id = cmdq_push(CMD_CALIB, sel, 0, (uint16_t)(10 * mA));   // queue a CALIB command to PIC
+      if (id < 0)
+      {
+        request->send(503, "text/plain", "Command queue full!\n");
+        return;
+      }
+      snprintf(buf, sizeof(buf), "/calib?vz=%d&max_mA=%.1f&id=%d\n", sel, mA, id);
+      request->send(200, "text/plain", buf);
+      return;
+    }
+  }
+  request->send(400, "text/plain", "Parameter error: vz=[1..4]&max_mA=[0.1 .. 100.0]\n");
+
+} // webUI_calib ()
+
+
+/** @brief Handler for PARAM (PIC parameter table, see paramName[]).
+ *  Arguments: <ESP_IP>/param?<name>=<value> queues "Param:ix,value", the PIC checks the range
+ *  and stores the value in its EEPROM (result: <ESP_IP>/queue?id=nn). 
+
+ *  Without arguments: the values read from the PIC as JSON object (-1: unknown),
+ *  p.e. {"tick_ms":100,"home_s":120, ... ,"log_div":1}
+ */
+void webUI_param (AsyncWebServerRequest *request)
+{
+  char  buf[256];
+  int   n = 0;
+  int   id;
+  int   value;
+
+  if (request->args() == 0)
+  {
+    for (int i = 0; i < NUM_PARAM; i++)
+    {
+      n += snprintf(&buf[n], sizeof(buf) - n, "%c\"%s\":%d", i ? ',' : '{', paramName[i], param[i]);
+    }
+    snprintf(&buf[n], sizeof(buf) - n, "}");
+    request->send(200, "text/plain", buf);
+    return;
+  }
+
+  for (int i = 0; i < NUM_PARAM; i++)
+  {
+    if (!request->hasArg(paramName[i])) continue;
+    value = request->arg(paramName[i]).toInt();
+    if ((value < 0) || (value > 0xFFFF)) break;
+
+    id = cmdq_push_args(CMD_PARAM, i, (uint16_t) value);   // queue a PARAM command to PIC
+    if (id < 0)
+    {
+      request->send(503, "text/plain", "Command queue full!\n");
+      return;
+    }
+    snprintf(buf, sizeof(buf), "/param?%s=%d&id=%d\n", paramName[i], value, id);
+    request->send(200, "text/plain", buf);
+    return;
+  }
+  request->send(400, "text/plain", "Parameter error: tick_ms, home_s, overcurr, mux_overcurr, duty_max, "
+                                   "duty_start, duty_slow, ramp_ms, slow_pct or log_div=[0 .. 65535]\n");
+
+} // webUI_param ()
+
+
 /** @brief Handler for INFO request.
  */
-void webUI_info ()
+void webUI_info (AsyncWebServerRequest *request)
 {
   char  buf[128];
   String htmlPage;
@@ -198,16 +388,16 @@ void webUI_info ()
     "}\n");
 
   //server.sendHeader("Access-Control-Allow-Origin","*"); 
-  server.send(200, "text/plain", htmlPage);
+  request->send(200, "text/plain", htmlPage);
 
-  flags.version = 1;      // update PIC firmware version (next loop)
+  cmdq_push(CMD_VERSION, 0, 0, 0);  // update PIC firmware version (next loop)
 
 } // webUI_info ()
 
 
 /** @brief Handler for "SAVE" (@todo: POST). Arguments: <ESP_IP>/save?ssid=<string>&psk=<password>
  */
-void webUI_save ()
+void webUI_save (AsyncWebServerRequest *request)
 {
   int error = 1;  // preset!
   char  buf[128];
@@ -216,10 +406,10 @@ void webUI_save ()
   String  id;
   String  pwd;
 
-  if (server.hasArg("ssid") && server.hasArg("psk")) 
+  if (request->hasArg("ssid") && request->hasArg("psk")) 
   {
-    id = server.arg("ssid");
-    pwd = server.arg("psk");
+    id = request->arg("ssid");
+    pwd = request->arg("psk");
     htmlPage = F("{\n"
     "\"save\": {\n"
     "  \"ssid\": \""); htmlPage += id;  htmlPage += F("\",\n"
@@ -232,51 +422,177 @@ void webUI_save ()
     strncpy(psk,  pwd.c_str(), sizeof(psk));
     psk[sizeof(psk)-1] = '\0';
 
-    flags.save = 1;   // set flag for new credentials (loop: save + reboot)
+    flag_save = true; // set flag for new credentials (loop: save + reboot)
     error = 0;
   }
   if (error) 
   {
     htmlPage = F("Parameter error: \n");
-    for (uint8_t i = 0; i < server.args(); i++) 
+    for (uint8_t i = 0; i < request->args(); i++) 
     {
-       htmlPage += server.argName(i) + "=" + server.arg(i) + "\n";
+       htmlPage += request->argName(i) + "=" + request->arg(i) + "\n";
     }    
   }
-  server.send(200, "text/plain", htmlPage);
+  request->send(200, "text/plain", htmlPage);
 
 } // webUI_save ()
 
 
-/** @brief Handler for STATUS request. \n
- *  Contains all readings and status' from PIC µC.
- *  May be extended, because data is parsed as JSON object (name:value).
+/** @brief Handler for QUEUE request. Arguments: <ESP_IP>/queue[?id=nn] \n
+ *  Returns the state of command nn as JSON object, or all commands in the queue as JSON array.
+ */
+void webUI_queue (AsyncWebServerRequest *request)
+{
+  static char buf[CMDQ_SIZE * 84 + 8];  // 79 chars per entry + separators
+  const CMD *cmd;
+
+  if (request->hasArg("id"))
+  {
+    cmd = cmdq_find(request->arg("id").toInt());
+    if (cmd)
+    {
+      cmdq_json(cmd, buf, sizeof(buf));
+      request->send(200, "text/plain", buf);
+    }
+    else request->send(404, "text/plain", "Unknown id\n");
+  }
+  else
+  {
+    cmdq_json_all(buf, sizeof(buf));
+    request->send(200, "text/plain", buf);
+  }
+
+} // webUI_queue ()
+
+
+/** @brief Handler for SCHED request. Returns the scheduler statistics (idle time, runs,
+ *  overruns and execution times of the jobs) as JSON and resets them.
  */
-void webUI_status ()
+void webUI_sched (AsyncWebServerRequest *request)
 {
-  create_jStatus (jStatus, sizeof(jStatus), true);   // create pretty JSON document
-  server.send(200, "text/plain", jStatus);
+  static char buf[1024];  // ca. 130 chars per job
+
+  sched_json(buf, sizeof(buf));
+  request->send(200, "text/plain", buf);
+
+} // webUI_sched ()
+
+
+/** @brief Handler for STATUS. Arguments: <ESP_IP>/status[?since=<version>]
+ *  Serves the cached status snapshot (see status.ino) with ETag "<version>":
+ *  - If-None-Match equal to the current ETag, or since == version: HTTP 304 (not modified)
+ *  - since < version: only the fields changed since this version (p.e. { "version": 18, "mAmps": 12.3 })
+ *  - else: the complete status
+ */
+void webUI_status (AsyncWebServerRequest *request)
+{
+  static char buf[512];
+  char        etag[16];
+  uint32_t    since;
+  AsyncWebServerResponse *response;
+
+  status_update();
+  snprintf(etag, sizeof(etag), "\"%lu\"", (unsigned long) status_version());
+
+  if (request->hasArg("since"))
+  {
+    since = strtoul(request->arg("since").c_str(), NULL, 10);
+    if (since == status_version())
+    {
+      response = request->beginResponse(304);
+    }
+    else if (since < status_version())
+    {
+      status_delta(since, buf, sizeof(buf));
+      response = request->beginResponse(200, "text/plain", buf);
+    }
+    else  // since > version: client knows a version of a former boot, send complete status
+    {
+      response = request->beginResponse(200, "text/plain", status_json());
+    }
+  }
+  else if (request->hasHeader("If-None-Match") && (request->header("If-None-Match") == etag))
+  {
+    response = request->beginResponse(304);
+  }
+  else response = request->beginResponse(200, "text/plain", status_json());  // (copy of the cache)
+
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
 
 } // webUI_status ()
 
 
+/** @brief Handler for UPDATE (GET): form for the OTA update of the ESP firmware.
+ */
+void webUI_update (AsyncWebServerRequest *request)
+{
+  request->send(200, "text/html", F(
+    "<form method='POST' action='/update' enctype='multipart/form-data'>"
+    "Firmware: <input type='file' accept='.bin,.bin.gz' name='firmware'> "
+    "<input type='submit' value='Update Firmware'></form>"));
+
+} // webUI_update ()
+
+
+/** @brief Handler for UPDATE (POST): called after the upload (webUI_upload_fw()) has completed.
+ *  On success loop() reboots the ESP.
+ */
+void webUI_updated (AsyncWebServerRequest *request)
+{
+  if (Update.hasError())
+  {
+    request->send(500, "text/plain", "Update failed!\n");
+  }
+  else
+  {
+    request->send(200, "text/plain", "Update Success! Rebooting...\n");
+    flag_reboot = true;   // loop: reboot
+  }
+
+} // webUI_updated ()
+
+
+/** @brief Upload handler for UPDATE (POST): writes the firmware image into the flash.
+ *  Called for each received chunk of the file.
+ */
+void webUI_upload_fw (AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
+{
+  if (index == 0)   // first chunk
+  {
+    Update.runAsync(true);  // no yield() in the TCP callback
+    Update.begin((ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000);
+  }
+  if (!Update.hasError() && (Update.write(data, len) != len))
+  {
+    Update.end();   // abort
+  }
+  if (final && !Update.hasError())
+  {
+    Update.end(true);   // true: set the size to the current progress
+  }
+
+} // webUI_upload_fw ()
+
+
 /** @brief Handler for all NotFound requests (invalid URIs)
  */
-void webUI_notFound () 
+void webUI_notFound (AsyncWebServerRequest *request)
 {
   String message = "File Not Found\n\n";
   message += "URI: ";
-  message += server.uri();
+  message += request->url();
   message += "\nMethod: ";
-  message += (server.method() == HTTP_GET) ? "GET" : "POST";
+  message += request->methodToString();
   message += "\nArguments: ";
-  message += server.args();
+  message += request->args();
   message += "\n";
-  for (uint8_t i = 0; i < server.args(); i++) 
+  for (uint8_t i = 0; i < request->args(); i++) 
   { 
-    message += " " + server.argName(i) + ": " + server.arg(i) + "\n"; 
+    message += " " + request->argName(i) + ": " + request->arg(i) + "\n"; 
   }
-  server.send(404, "text/plain", message);
+  request->send(404, "text/plain", message);
 
 } // webUI_notFound ()
 
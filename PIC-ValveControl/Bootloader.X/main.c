@@ -14,6 +14,10 @@
  *                   - Memory Model | Rom Range: 0-7FF
  * 
  * Change Log:
+ * 2026-10-16 v0.9
+ * - Baud rate negotiation: "Baud:<rate>" is echoed at the current rate, then
+ *   the rate is switched. Unless the same line is received at the new rate
+ *   within BAUD_VERIFY_MS, the bootloader falls back to 38400 Bd.
  * 2024-01-29 v0.7.1
 * - Error corrected when copying code to bufferRam.
  * 2023-11-23 v0.6
@@ -37,6 +41,7 @@
 #define  NEW_INTERRUPT_VECTOR_LOW    0x0818
 
 #define PAGESIZE           128      /* no. of WORDs */
+#define BAUD_VERIFY_MS     500      /* new baud rate must be confirmed within */
 
 #define  _str(x)  #x
 #define  str(x)  _str(x)
@@ -58,8 +63,15 @@ uint16_t    procID;         // processor ID
 uint16_t   *bufferRamPtr;
 
 // *** private variables
+/// Baud rates of the negotiation (@16 MHz, BRGS = 1: Baud = 4e6 / (BRG + 1))
+static const uint32_t   baud_rate[] = { 38400, 115200, 250000, 500000 };
+static const uint8_t    baud_brg[]  = { 103,   34,     15,     7 };
+static uint8_t          baud_ix;    // current baud rate (index of baud_rate[])
+
 // *** private function prototypes
 static uint8_t  uart1_Read (void);
+static uint8_t  baud_find (volatile uint8_t *p);
+static void     baud_set (uint8_t ix);
 static uint8_t 	xtou8 (uint8_t *);
 static char     u8tox (uint8_t n);
 
@@ -126,6 +138,9 @@ void main(void)
     uint8_t     offset;         // addr offset relative to base_addr
     uint16_t    data;           // data word (2 byte) to get flashed
     uint16_t   *bufPtr;
+    uint8_t     baud;           // index of baud_rate[] requested by "Baud:"
+    bool        verify = false; // new baud rate not yet confirmed
+    uint16_t    timeout;
     
     // SYSTEM_Initialize:
     init_pmd();
@@ -163,7 +178,18 @@ void main(void)
         error = 0;
         for (eol = false, index = 0; !eol && (index < sizeof(record.buffer)); )
         {
-            while (!PIR4bits.U1RXIF) ;
+            for (timeout = 0; !PIR4bits.U1RXIF; )
+            {
+                if (!verify) continue;
+                __delay_us(10);
+                if (++timeout >= BAUD_VERIFY_MS * 100)
+                {   // new baud rate not confirmed: fall back to 38400 Bd
+                    baud_set(0);
+                    verify = false;
+                    break;
+                }
+            }
+            if (!PIR4bits.U1RXIF) break;
             
 //          if (U1ERRIRbits.RXFOIF || U1ERRIRbits.FERIF)
 //          (FERIF: ignore "break" caused by "Serial.swap()" in ESP)
@@ -279,6 +305,15 @@ void main(void)
             
         } // if : data record
         
+        // baud rate negotiation: the 1st line after a switch must confirm it
+        baud = baud_find(record.buffer);
+        if (verify && (baud != baud_ix))
+        {   // not confirmed (p.e. garbage at the new rate): fall back to 38400 Bd
+            baud_set(0);
+        }
+        if (verify || (baud == baud_ix)) baud = sizeof(baud_brg);   // no switch
+        verify = false;
+        
         // echo back unprocessed input line ("Bootload!", BL addresses or Errs)
         for (uint8_t k = 0; k < sizeof(record.buffer); k++) 
         {
@@ -290,6 +325,12 @@ void main(void)
         putch('\n');
         while (!U1ERRIRbits.TXMTIF) ;  // until shift reg. is empty
         
+        if (baud < sizeof(baud_brg))
+        {   // "Baud:" has been echoed at the current rate: switch
+            baud_set(baud);
+            verify = (baud != 0);
+        }
+        
     } // while (!EOF)
     
     RESET();    // if type == EOF
@@ -301,6 +342,41 @@ void main(void)
 
 // *** private function bodies
 
+/** @brief Checks for the command "Baud:<rate>".
+ *  @return index of <rate> in baud_rate[] or sizeof(baud_brg), if the line
+ *  is no baud command or the rate is not supported.
+ */
+static uint8_t
+baud_find (volatile uint8_t *p)
+{
+    uint32_t    rate = 0;
+
+    if ((p[0] != 'B') || (p[1] != 'a') || (p[2] != 'u') || (p[3] != 'd') 
+        || (p[4] != ':')) return (sizeof(baud_brg));
+    for (p += 5; (*p >= '0') && (*p <= '9'); p++) rate = rate * 10 + (*p - '0');
+
+    for (uint8_t i = 0; i < sizeof(baud_brg); i++)
+    {
+        if (rate == baud_rate[i]) return (i);
+    }
+    return (sizeof(baud_brg));
+
+} // baud_find ()
+
+
+/** @brief Sets the baud rate baud_rate[ix] (after the shift reg. is empty).
+ *  The UART keeps running, chars received meanwhile are garbage.
+ */
+static void
+baud_set (uint8_t ix)
+{
+    while (!U1ERRIRbits.TXMTIF) ;   // until shift reg. is empty
+    U1CON0bits.BRGS = 1;            // high speed: Baud = Fosc / (4 * (BRG + 1))
+    U1BRG = baud_brg[ix];
+    baud_ix = ix;
+
+} // baud_set ()
+
 
 /** @brief Function to convert two ANSI hexadecimal chars to an uint8_t result.
  *  The 2st char is the high nibble and the 2nd char is the low nibble.
@@ -5,6 +5,9 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Added adc_trigger(): burst average conversion, started by a hardware 
+ *   trigger, completion signalled by ADTIF (no polling, no delay)
  * 2023-10-17 V0.1
  * - Initial issue
  */
@@ -92,6 +95,41 @@ adc_wait (void)
 } // adc_wait ()
 
 
+/** @brief  Arms the ADC for a hardware triggered burst: the trigger source
+ *  adact starts (1 << ADC_BURST_SHIFT) conversions of channel chs (each with 
+ *  ACQ_TAD acquisition time, timed by the ADC). Their average is available in
+ *  ADFLTR, when ADTIF gets set (ADTIE enabled). Returns at once. \n
+ *  Set ADACT = 0 after reading the result to release the ADC.
+ *  @param  chs     Binary code of voltage source, see datasheet: 40.7.8 ADPCH
+ *          adact   auto-conversion trigger source, see datasheet: ADACT
+ */
+void 
+adc_trigger (uint8_t chs, uint8_t adact)
+{
+    ADCON0 = 0;                 /// - ADC stop & disable, clock supplied by FOSC
+    ADCON0bits.FM = 1;          /// - ADRES+ADPREV data right-justified
+    ADPRE = 0;                  /// - no precharge
+    ADACQ = ACQ_TAD;            /// - acquisition time (instead of a delay)
+    ADCON1 = 0;                 /// - Double-Sample disable
+    ADCON2 = 0;
+    ADCON2bits.CRS = ADC_BURST_SHIFT;   /// - ADFLTR = ADACC >> CRS (average)
+    ADCON2bits.ACLR = 1;        /// - clear ADACC and ADCNT
+    ADCON2bits.MD = 0b011;      /// - Burst Average mode
+    ADCON3 = 0;
+    ADCON3bits.TMD = 0b111;     /// - ADTIF after every burst (no threshold)
+    ADRPT = 1 << ADC_BURST_SHIFT;   /// - conversions per burst
+    ADREF = 0x03;               /// - VREF- = AVSS, VREF+ = internal ADFVR  
+    ADCLK = 15;                 /// - Clock divider: Conversion clock = FOSC/32
+    ADPCH = chs;                /// - ADC Positive Input = chs
+
+    PIR1bits.ADTIF = 0;         /// - Clear threshold interrupt flag
+    PIE1bits.ADTIE = 1;         /// - Enable threshold interrupt (burst done)
+    ADACT = adact;              /// - External Trigger
+    ADCON0bits.ADON = 1;        /// - Turn on the ADC module
+    
+} // adc_trigger ()
+
+
 // *** private function bodies
 
 /**
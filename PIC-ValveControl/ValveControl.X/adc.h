@@ -5,6 +5,8 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */ 
 /*  Change Log:
+ *  2026-10-16 v0.9
+ *  - Hardware triggered burst average (adc_trigger())
  *  2023-11-23 V0.6
  *  - First issue
  */
@@ -15,11 +17,14 @@
 // data type, constant and macro definitions
 #define ACQ_US_DELAY    50
 #define ACQ_US_TIMEOUT  50
+#define ACQ_TAD         (ACQ_US_DELAY / 2)  /* acquisition time [TAD = 2 µs] (adc_trigger()) */
+#define ADC_BURST_SHIFT 1   /* burst of (1 << ADC_BURST_SHIFT) conversions, averaged */
 
 // function prototypes
 void    adc_init (uint8_t chs);
 void    adc_start (uint8_t chs);
 int8_t  adc_wait (void);
+void    adc_trigger (uint8_t chs, uint8_t adact);
 
 #endif	/* _ADC_H */
 
@@ -5,6 +5,18 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /*  Change Log:
+ * 2026-10-16 v0.9
+ * - The back EMF is no longer read by polling within the PWM1_isr() (400 µs 
+ *   delay + 2 conversions): daq_vbemf_arm() lets TMR2 trigger a burst 
+ *   average BEMF_SETTLE_US after the H-bridge OFF, daq_vbemf_read() takes the
+ *   result in the ADC threshold ISR. daq_vdd() and daq_temperature() don't 
+ *   use the ADC while it is armed (and vice versa). The main loop measures
+ *   VDD every VDD_MS while no motor runs, so no back EMF sample is lost.
+ * - Sample ring (SPSC): the ISRs only capture the raw current and back EMF
+ *   (daq_put_isr()), daq_process() filters, logs and integrates them in the
+ *   main loop (formerly in I2C1RX_isr() and ADT_isr()).
+ * - The data logger takes every g_log_div-th sample (param.c), so a long
+ *   travel fits into LOGSIZE.
  * 2023-10-17 V0.1
  * - Initial issue
  */
@@ -13,6 +25,45 @@
 #include "main.h"
 #include "adc.h"
 #include "daq.h"
+#include "motor.h"
+
+// *** data type, constant and macro definitions
+#define ADACT_TMR2      0x04    /* ADC auto-conversion trigger: TMR2_postscaled (datasheet: ADACT) */
+
+//#define USE_mAMP_LoPASS     1
+//#define USE_BEMF_LoPASS     1
+
+#define NLoPASS_BEMF        1
+#define NLoPASS_CURR        1
+/*  Low Pass Filter
+    y(k) = a * u(k) + b * y(k-1);       b = 1 - a;
+    y(k) = a * u(k) + y(k-1) - a * y(k-1);
+A very fast implementation of 'a * u(k)' and '- b * y(k-1)' simply shifts 
+the values u(k) and y(k-1) by NLoPASS bit to the right. This results in:
+NLoPASS  1       2       3       4       5
+a:      1/2     1/4     1/8     1/16    1/32    = (1 >> NLoPASS)
+Ts/T:	1.44	3.48	7.49	15.5	31.5    Time Constant / Sample Interval
+*/
+
+// *** global variables
+uint8_t                 g_log_div = LOG_DIV;    ///< data logger: every n-th sample (param.c)
+
+// *** private variables
+static volatile bool    daq_busy;       ///< ADC used by the main loop (no back EMF sample)
+static uint16_t         daq_vdd_last = 999; ///< last VDD (returned while the ADC is armed)
+
+/* Sample ring: written by the low priority ISRs only (they don't interrupt
+ * each other), read by the main loop only. Each index is written by one side
+ * only (single byte: atomic), so no interrupt needs to be disabled. */
+static SAMPLE_t         ring[SAMPLE_RING];  ///< raw samples
+static volatile uint8_t ring_head;      ///< next entry to write (ISR)
+static volatile uint8_t ring_tail;      ///< next entry to read (main loop)
+static uint8_t          log_ncurr;      ///< current samples since the last logged one
+static uint8_t          log_nbemf;      ///< back EMF samples since the last logged one
+
+// *** private function prototypes
+static void daq_curr (const SAMPLE_t *s);
+static void daq_bemf (const SAMPLE_t *s);
 
 
 /** @brief Returns an uncalibrated temperature estimation. \n
@@ -43,6 +94,12 @@ daq_temperature (void)
     while (NVMCON0bits.GO);     // wait for the read operation to complete
     TSHR3 = (int16_t) NVMDAT;   // 0x1A03 = 6659
     
+    daq_busy = true;
+    if (ADACT) 
+    {   // ADC armed for the back EMF (daq_vbemf_arm())
+        daq_busy = false;
+        return (tempC);
+    }
     adc_init (0x3C);        // ADPCH = Temp. Indicator, VREF+ = ADFVR (2x)
     sum = 0;
     for (uint8_t i = 0; (i < 8) && (error == 0); i++)
@@ -60,6 +117,7 @@ daq_temperature (void)
         tempC += TSHR3;
         //tempC /= 10;      don't divide by 10 - we return in 1/10th degree
     }   
+    daq_busy = false;
     return ((int16_t) tempC);
     
 } // daq_temperature()
@@ -69,6 +127,7 @@ daq_temperature (void)
  *  With ADC_VREF+ = VDD and ADC_Positive_Input = FVR1 we get: \n
  *  u(VFR1) = ADRES * Vdd / 4095 := FVRA2X / 1000 => \n
     Vdd = FVR2AX * 4095 / 1000 / ADRES      ; in [V]
+ *  While the ADC is armed for the back EMF, the last value is returned.
  *  @return  Voltage [0.01 V]
  */
 uint16_t
@@ -77,6 +136,12 @@ daq_vdd (void)
     uint32_t    v;
     uint16_t    vdd;
     
+    daq_busy = true;        // (daq_vbemf_arm() skips this period)
+    if (ADACT)              // ADC armed for the back EMF?
+    {
+        daq_busy = false;
+        return (daq_vdd_last);
+    }
     adc_init(0b111110);     // ADC Positive Input = FVR1 (ADC module)
     ADREF = 0;              // change VREF+ = VDD
     adc_start(0b111110);
@@ -96,24 +161,29 @@ daq_vdd (void)
         vdd = (uint16_t) (v / ADRES);     // in [0.01 V]
     }
 #endif    
+    daq_busy = false;
+    daq_vdd_last = vdd;
     return (vdd);
     
 } // daq_vdd ()
 
 
 
-/** @brief Reads the back EMF voltage of channel vz. \n
- *  Returns the raw ADC RESULT. \n
- *  Exec time ca. 100 µs
- *  @return  Voltage [ADC raw]
+/** @brief Arms the ADC to sample the back EMF voltage of channel vz. \n
+ *  Call from PWM1_isr() on the right edge of slice 1 (H-bridge OFF): the same
+ *  edge has started TMR2 (monostable), which triggers the burst average 
+ *  BEMF_SETTLE_US later. The ADC threshold interrupt signals the result 
+ *  (daq_vbemf_read()). Exec time a few µs.
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ *  @return false:  ADC in use by the main loop (no sample in this period)
  */
-uint16_t 
-daq_vbemf (uint8_t vz)
+bool 
+daq_vbemf_arm (uint8_t vz)
 {
     uint8_t     chs;
-    uint32_t    uval32;
-    uint16_t    vbemf = 0;
     
+    if (daq_busy) return (false);
+
     switch (vz)
     {
         case 4: 
@@ -130,21 +200,150 @@ daq_vbemf (uint8_t vz)
             break;
     }
 
-    adc_init(chs);     // ADC Positive Input = FVR1 (ADC module), FVR: 2.048 V
-    adc_start(chs);
+    adc_trigger(chs, ADACT_TMR2);   // VREF+ = FVR1 (ADC module), FVR: 2.048 V
+    return (true);
+
+} // daq_vbemf_arm ()
 
-    if (adc_wait() < 0) vbemf = g_vbemf;    // if timeout: keep previous value
-    else                vbemf = ADRES;      // Basic mode
 
-    // read twice and average
-    adc_start(chs);
-    if (adc_wait() < 0) vbemf += g_vbemf;    // if timeout: keep previous value
-    else    vbemf += ADRES;    
-    vbemf >>= 1;
+/** @brief Returns the back EMF sampled by daq_vbemf_arm() (average of the
+ *  burst) and releases the ADC. Call from the ADC threshold ISR.
+ *  @return  Voltage [ADC raw]
+ */
+uint16_t 
+daq_vbemf_read (void)
+{
+    uint16_t    vbemf = ADFLTR;
     
+    ADACT = 0;                  // no further trigger: ADC released
+    PIE1bits.ADTIE = 0;
     return (vbemf);
 
-} // daq_vbemf ()
+} // daq_vbemf_read ()
+
+
+/** @brief Captures a raw sample into the sample ring (processed later by
+ *  daq_process()). Call from the low priority ISRs only. A sample, which
+ *  doesn't fit (main loop blocked for more than SAMPLE_RING / 2 PWM periods),
+ *  is dropped and signalled by g_ERRORflags.SAMPLE_LOST.
+ *  @param  type:   SampleTypes
+ *          vz:     zone (current: solo zone, 0: all)
+ *          dir:    direction of the zone (back EMF)
+ *          weight: PWM periods represented by the sample (back EMF)
+ *          value:  current / 0.1 mA or back EMF [ADC raw]
+ */
+void
+daq_put_isr (uint8_t type, uint8_t vz, int8_t dir, uint8_t weight, uint16_t value)
+{
+    uint8_t     head = ring_head;
+    uint8_t     next = (head + 1) & (SAMPLE_RING - 1);
+
+    if (next == ring_tail)
+    {
+        g_ERRORflags.SAMPLE_LOST = 1;
+        return;
+    }
+    ring[head].type   = type;
+    ring[head].vz     = vz;
+    ring[head].dir    = dir;
+    ring[head].weight = weight;
+    ring[head].value  = value;
+    ring_head = next;           // (entry complete: publish)
+
+} // daq_put_isr ()
+
+
+/** @brief Processes the samples captured since the last call, in the order 
+ *  of capture (current and back EMF of a PWM period stay together).
+ *  Call on every pass of the main loop, before the state machine evaluates 
+ *  g_mAx10 and the stall detection.
+ */
+void
+daq_process (void)
+{
+    uint8_t     tail = ring_tail;
+
+    while (tail != ring_head)
+    {
+        if (SAMPLE_BEMF == ring[tail].type) daq_bemf(&ring[tail]);
+        else daq_curr(&ring[tail]);
+        tail = (tail + 1) & (SAMPLE_RING - 1);
+        ring_tail = tail;       // (entry free)
+    }
+
+} // daq_process ()
+
+
+// *** private function bodies
+
+/** @brief Processes a current sample (1 LSB = 10μV, Rs = 0,1 Ohm => 
+ *  I / 0.1 mA = Us / 10µV):
+ *  - sets g_mAx10
+ *  - while the motor is driven: logs g_mAx10 (every g_log_div-th sample),
+ *    passes the sample to motor.c
+ *  @param  s:      sample (SAMPLE_CURR or SAMPLE_CURR_IDLE)
+ */
+static void
+daq_curr (const SAMPLE_t *s)
+{
+    int16_t     mAmps = (int16_t) s->value;
+
+    if (mAmps < 0) mAmps = 0;   // offset may cause negative readings ??
+
+#ifdef USE_mAMP_LoPASS
+    g_mAx10 += (mAmps - g_mAx10) >> NLoPASS_CURR;    // is usually > 0
+#else
+    g_mAx10 = mAmps;
+#endif
+    if (SAMPLE_CURR_IDLE == s->type) return;    // idle (see state_idle)
+
+    if ((g_ns_curr < LOGSIZE) && (++log_ncurr >= g_log_div))
+    {
+        log_ncurr = 0;
+        g_curr_log[g_ns_curr++] = (uint8_t)(g_mAx10 >> 2);
+    }  
+#ifdef TEST_mAMPS2DAC
+    DAC1DATL = (uint8_t) (g_mAx10 >> 2);    // current monitor (16 -> 8 bit)
+#endif
+    if (g_mux_zones) motor_sample(s->vz, mAmps);    // concurrent zones
+
+} // daq_curr ()
+
+
+/** @brief Processes a back EMF sample:
+ *  - filters and logs g_vbemf (every g_log_div-th sample)
+ *  - passes the sample to the stall detection (motor_bemf())
+ *  - sums up g_vbemf_sum[] (position estimator)
+ *  @param  s:      sample (SAMPLE_BEMF)
+ */
+static void
+daq_bemf (const SAMPLE_t *s)
+{
+#ifdef USE_BEMF_LoPASS
+    // see: PIC datasheet 40.5.6 Low-Pass Filter Mode and microchip AN2749
+    g_vbemf += (s->value - g_vbemf) >> NLoPASS_BEMF;  // is usually > 0
+#else
+    g_vbemf = s->value;
+#endif
+    // data logger: save g_vbemf into bemf_log[]
+    if ((g_ns_bemf < LOGSIZE) && (++log_nbemf >= g_log_div))
+    {
+        log_nbemf = 0;
+        g_vbemf_log[g_ns_bemf++] = (uint8_t)(g_vbemf >> 4);
+    }
+    
+#ifdef TEST_VBEMF2DAC
+    // monitor VBEMF (16 -> 8 bit) - requires DACout routed to a pin
+    DAC1DATL = (uint8_t) (g_vbemf >> 4);
+#endif
+    // stall detection (current and back EMF of this period, see motor.c)
+    motor_bemf(s->vz, s->value);
+
+    // sum up speed (~ distance, see motor_position())
+    if      (s->dir > 0) g_vbemf_sum[s->vz] += (int32_t) g_vbemf * s->weight;
+    else if (s->dir < 0) g_vbemf_sum[s->vz] -= (int32_t) g_vbemf * s->weight;      
+
+} // daq_bemf ()
 
 
 /**
@@ -5,6 +5,10 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */ 
 /*  Change Log:
+ *  2026-10-16 v0.9
+ *  - Back EMF sampled by the hardware (daq_vbemf_arm(), daq_vbemf_read())
+ *  - Sample ring: ISRs capture, the main loop processes (daq_put_isr(), daq_process())
+ *  - Data logger decimation g_log_div (param.c)
  *  2023-11-23 V0.6
  *  - First issue
  */
@@ -12,11 +16,35 @@
 #define	_DAQ_H
 
 // global variables
+extern uint8_t  g_log_div;      // data logger: every g_log_div-th sample
+
 // data type, constant and macro definitions
+#define BEMF_SETTLE_US  400     /* [µs] H-bridge OFF to back EMF sample (TMR2, see init_timer2()) */
+#define LOG_DIV         1       /* default decimation of the data logger (g_log_div) */
+#define SAMPLE_RING     16      /* entries of the sample ring (power of 2, 2 samples per PWM period) */
+
+/// Types of raw samples (see daq_put_isr())
+enum SampleTypes {
+    SAMPLE_CURR = 0,    //!< motor current (INA219), motor driven
+    SAMPLE_CURR_IDLE,   //!< motor current (INA219), idle
+    SAMPLE_BEMF,        //!< back EMF (ADC burst average)
+};
+
+/// Raw sample, captured by an ISR and processed by daq_process()
+typedef struct {
+    uint8_t     type;       //!< SampleTypes
+    uint8_t     vz;         //!< zone (current: solo zone, 0: all)
+    int8_t      dir;        //!< direction of the zone (back EMF)
+    uint8_t     weight;     //!< PWM periods represented by the sample (back EMF)
+    uint16_t    value;      //!< current / 0.1 mA or back EMF [ADC raw]
+} SAMPLE_t;
 
 // function prototypes
 int16_t  daq_temperature (void);
-uint16_t daq_vbemf (uint8_t vz);
+bool     daq_vbemf_arm (uint8_t vz);
+uint16_t daq_vbemf_read (void);
 uint16_t daq_vdd (void);
+void     daq_put_isr (uint8_t type, uint8_t vz, int8_t dir, uint8_t weight, uint16_t value);
+void     daq_process (void);
 
 #endif	/* _DAQ_H */
@@ -0,0 +1,160 @@
+/**
+ * @file fmt.c
+ *  @brief  Small integer / hex formatter and parser (replaces printf, scanf)
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  The commands and responses of the ESP consist of a token and a list of
+ *  integers only ("Move:1,50,300", "Tick:86,86,90,88"). sprintf() / sscanf()
+ *  pull the large doprnt / doscan runtime of XC8 into the flash and take
+ *  milliseconds per call. These functions only handle what is needed:
+ *  - fmt_dec() / fmt_hex() append a value and a separator to a buffer and
+ *    return the new end, so a response is built by chained calls. Decimals
+ *    are converted by subtraction of powers of ten (no 32 bit division).
+ *  - fmt_parse() reads a comma separated list of decimals (like sscanf()
+ *    with "%d,%d,...", returns the number of values).
+ *  No XC8 specific code: the module is also built on the host (see
+ *  ../bench/bench.c).
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fmt.h"
+
+// *** data type, constant and macro definitions
+#define NUM_POW10       9       /* entries of pow10[] */
+
+// *** global variables
+
+// *** private variables
+static const uint32_t   pow10[NUM_POW10] = {    ///< digit weights of fmt_dec()
+    1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 10000UL, 1000UL, 100UL, 10UL
+};
+
+// *** public function bodies
+
+/** @brief Appends a string.
+ *  @param  p:  write position (is terminated by '\0')
+ *          s:  string
+ *  @return new write position (at '\0')
+ */
+char *fmt_str (char *p, const char *s)
+{
+    while (*s) *p++ = *s++;
+    *p = '\0';
+    return (p);
+
+} // fmt_str ()
+
+
+/** @brief Appends a signed decimal and a separator (like "%ld,").
+ *  @param  p:      write position (is terminated by '\0')
+ *          v:      value
+ *          sep:    char after the value (p.e. ',' or '\n'), 0: none
+ *  @return new write position (at '\0')
+ */
+char *fmt_dec (char *p, int32_t v, char sep)
+{
+    uint32_t    u = (uint32_t) v;
+    bool        lead = true;    // suppress leading zeros
+
+    if (v < 0)
+    {
+        *p++ = '-';
+        u = 0 - u;
+    }
+    for (uint8_t i = 0; i < NUM_POW10; i++)
+    {
+        char    d = '0';
+
+        while (u >= pow10[i])
+        {
+            u -= pow10[i];
+            d++;
+        }
+        if (lead && (d == '0')) continue;
+        *p++ = d;
+        lead = false;
+    }
+    *p++ = (char) ('0' + u);    // (units also for 0)
+    if (sep) *p++ = sep;
+    *p = '\0';
+    return (p);
+
+} // fmt_dec ()
+
+
+/** @brief Appends a hexadecimal with a fixed number of digits (like "%04X,").
+ *  @param  p:      write position (is terminated by '\0')
+ *          v:      value
+ *          digits: number of digits [1 .. 8]
+ *          sep:    char after the value, 0: none
+ *  @return new write position (at '\0')
+ */
+char *fmt_hex (char *p, uint32_t v, uint8_t digits, char sep)
+{
+    for (uint8_t shift = (uint8_t) (4 * digits); shift > 0; )
+    {
+        uint8_t     nibble;
+
+        shift -= 4;
+        nibble = (uint8_t) (v >> shift) & 0x0F;
+        *p++ = (char) ((nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble));
+    }
+    if (sep) *p++ = sep;
+    *p = '\0';
+    return (p);
+
+} // fmt_hex ()
+
+
+/** @brief Parses a comma separated list of signed decimals (like sscanf()
+ *  with "%ld,%ld,..."). Stops at the first char, which is neither part of a
+ *  number nor a comma, p.e. '\0' or '\n'. At most 9 digits per number.
+ *  @param  p:      first char
+ *          val:    array of results
+ *          n:      max. number of values
+ *  @return number of values parsed
+ */
+uint8_t fmt_parse (const char *p, int32_t *val, uint8_t n)
+{
+    uint8_t     count;
+
+    for (count = 0; count < n; count++)
+    {
+        uint32_t    u = 0;
+        uint8_t     digits = 0;
+        bool        neg = false;
+
+        while (*p == ' ') p++;
+        if (*p == '-')
+        {
+            neg = true;
+            p++;
+        }
+        for ( ; (*p >= '0') && (*p <= '9') && (digits < 9); p++, digits++)
+        {
+            u = (u << 3) + (u << 1) + (uint8_t) (*p - '0');     // u * 10 + digit
+        }
+        if (0 == digits) break;
+
+        val[count] = neg ? -(int32_t) u : (int32_t) u;
+        if (*p != ',')
+        {
+            count++;
+            break;
+        }
+        p++;
+    }
+    return (count);
+
+} // fmt_parse ()
+
+/**
+ End of File
+ */
@@ -0,0 +1,28 @@
+/**
+ *  @file fmt.h
+ *  @brief Declarations for module fmt.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ */
+#ifndef _FMT_H
+#define	_FMT_H
+
+#include <stdint.h>
+
+// data type, constant and macro definitions
+
+// global variables
+
+// function prototypes
+extern char    *fmt_str (char *p, const char *s);
+extern char    *fmt_dec (char *p, int32_t v, char sep);
+extern char    *fmt_hex (char *p, uint32_t v, uint8_t digits, char sep);
+extern uint8_t  fmt_parse (const char *p, int32_t *val, uint8_t n);
+
+#endif	/* _FMT_H */
+
@@ -0,0 +1,278 @@
+/**
+ * @file frame.c
+ *  @brief  Binary framed protocol between ESP and PIC
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  The ESP may negotiate binary frames by the ASCII query "Frame?" at startup.
+ *  A frame starts with FRAME_SYNC, which never is the first char of an ASCII
+ *  command, so both formats can be used side by side. The frames are assembled
+ *  by uart_poll() and dispatched by cmd_interpreter() to frame_interpreter().
+ *  A 'Status?' round trip needs 6 + 18 bytes instead of ca. 60 chars and
+ *  requires neither sprintf() nor sscanf().
+ *  Protocol version 2: once negotiated, the PIC sends the status on its own
+ *  (FRAME_STATUS_PUSH) on every change and as heartbeat (see frame_push()).
+ *  Protocol version 3: the status frame reports the number of waiting jobs.
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ * - Added unsolicited status frames (frame_push())
+ * - Added multi-zone move (frame_move())
+ * - Protocol version 3: status frame with the number of waiting jobs, 
+ *   FRAME_MOVE_REQ is queued as jobs while a home run is active
+ * - Frames are assembled by uart_poll() and sent by DMA (uart.c)
+ */
+
+#include <xc.h>             /* XC8 General Include File */
+#include "main.h"
+#include "frame.h"
+#include "uart.h"
+
+// *** global variables
+volatile bool   g_frame_mode;   ///< true: ESP has negotiated binary frames
+
+// *** private variables
+static uint8_t  push_position[NUM_VZ + 1];  ///< positions of the last status frame
+static uint16_t push_status;                ///< g_STATUSflags of the last status frame
+static bool     push_overcurr;              ///< OVER_CURR of the last status frame
+static uint8_t  push_state;                 ///< main state of the last status frame
+static uint16_t push_tick;                  ///< g_timer_ms of the last status frame
+static uint8_t  push_jobs;                  ///< g_jobq_count of the last status frame
+
+// *** private function prototypes
+static int8_t   frame_move (volatile uint8_t *data, uint8_t len);
+static void     frame_status (uint8_t type);
+
+// *** public function bodies
+
+/** @brief Updates the CRC-16/CCITT (poly 0x1021) by one data byte. \n
+ *  Table-free byte-wise algorithm (ca. 20 instructions per byte).
+ *  The same algorithm is used by the ESP (pic.ino).
+ *  @param  crc:    CRC of the preceding bytes (0xFFFF for the first byte)
+ *          data:   next data byte
+ *  @return updated CRC
+ */
+uint16_t frame_crc16 (uint16_t crc, uint8_t data)
+{
+    crc  = (uint16_t) ((crc >> 8) | (crc << 8));
+    crc ^= data;
+    crc ^= (crc & 0xFF) >> 4;
+    crc ^= crc << 12;
+    crc ^= (crc & 0xFF) << 5;
+
+    return (crc);
+
+} // frame_crc16 ()
+
+
+/** @brief Checks and executes a binary frame received from ESP.
+ *  - Frames with wrong length or CRC are answered by FRAME_ERROR (E_FRAME_CRC).
+ *  - Unknown frame types are answered by FRAME_ERROR (E_UNDEF_CMD).
+ *  @param  buf:    received frame (starting with FRAME_SYNC)
+ *          count:  number of received bytes
+ */
+void frame_interpreter (volatile uint8_t *buf, uint8_t count)
+{
+    uint16_t    crc = 0xFFFF;
+    uint8_t     len = buf[2];
+    int8_t      error = 0;
+
+    if ((count != (uint8_t) (len + FRAME_OVERHEAD)) || (len > FRAME_MAXDATA))
+    {
+        error = E_FRAME_CRC;
+    }
+    else
+    {
+        for (uint8_t i = 1; i < len + 3; i++) crc = frame_crc16(crc, buf[i]);
+        if ((buf[len + 3] != (uint8_t) crc) || (buf[len + 4] != (uint8_t) (crc >> 8)))
+        {
+            error = E_FRAME_CRC;
+        }
+    }
+
+    if (!error) switch (buf[1])     // frame type
+    {
+        case FRAME_STATUS_REQ:
+            frame_status(FRAME_STATUS);
+            break;
+
+        case FRAME_MOVE_REQ:
+            error = frame_move(&buf[3], len);
+            break;
+
+        default:
+            error = E_UNDEF_CMD;
+            break;
+    }
+
+    if (error)
+    {
+        frame_send(FRAME_ERROR, (const uint8_t *) &error, 1);
+    }
+
+} // frame_interpreter ()
+
+
+/** @brief Sends a binary frame to the ESP.
+ *  @param  type:   frame type (FrameTypes)
+ *          data:   payload
+ *          len:    number of payload bytes [0 .. FRAME_MAXDATA]
+ */
+void frame_send (uint8_t type, const uint8_t *data, uint8_t len)
+{
+    uint16_t    crc = 0xFFFF;
+
+    putch(FRAME_SYNC);
+    putch((char) type);
+    crc = frame_crc16(crc, type);
+    putch((char) len);
+    crc = frame_crc16(crc, len);
+    for (uint8_t i = 0; i < len; i++)
+    {
+        putch((char) data[i]);
+        crc = frame_crc16(crc, data[i]);
+    }
+    putch((char) crc);
+    putch((char) (crc >> 8));
+
+} // frame_send ()
+
+
+/** @brief Sends an unsolicited status frame (FRAME_STATUS_PUSH), when
+ *  - a position, the STATUSflags (ref, vz, move, home, ...), the OVER_CURR 
+ *    error, the number of waiting jobs or the main state have changed since 
+ *    the last status frame, or
+ *  - no status frame has been sent for HEARTBEAT_MS.
+ *  Call from the main loop. Does nothing unless binary frames have been
+ *  negotiated, and while a command is pending or bulk data (log data, 
+ *  bootload) is transmitted.
+ *  @param  state:  main state (state machine)
+ */
+void frame_push (uint8_t state)
+{
+    bool    changed = false;
+
+    if (!g_frame_mode || g_rs232_request) return;
+    if (g_STATUSflags.logdata || g_STATUSflags.bootload) return;
+
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
+    {
+        if (g_position[i] != push_position[i]) changed = true;
+    }
+    if (g_STATUSflags.v != push_status) changed = true;
+    if (g_ERRORflags.OVER_CURR != push_overcurr) changed = true;
+    if (g_jobq_count != push_jobs) changed = true;
+    if (state != push_state) changed = true;
+
+    if (changed || ((uint16_t) (g_timer_ms - push_tick) >= HEARTBEAT_MS))
+    {
+        push_state = state;     // (the other values are saved by frame_status())
+        frame_status(FRAME_STATUS_PUSH);
+    }
+
+} // frame_push ()
+
+
+// *** private function bodies
+
+/** @brief Executes FRAME_MOVE_REQ: sets the positions of several zones at once. \n
+ *  Payload: 1 .. NUM_VZ entries of 4 bytes: vz [1 .. NUM_VZ], setpos [0 .. 100],
+ *  mAx10 (int16) [1 .. 2000]. All entries are checked first, then all set 
+ *  positions are stored (all or nothing). The zones are queued in 
+ *  g_STATUSflags.pend and moved one after the other by the main loop. While a
+ *  home run is active or jobs are waiting, the entries are appended to the job
+ *  queue instead (the reference is checked, when the job is started).
+ *  Response FRAME_MOVE: pending zones (uint8, bit 0 = vz1).
+ *  @param  data:   payload
+ *          len:    number of payload bytes
+ *  @return 0 or error number (no response sent)
+ */
+static int8_t frame_move (volatile uint8_t *data, uint8_t len)
+{
+    uint8_t     vz, pos, mask = 0;
+    int16_t     mAx10;
+    bool        queue = g_STATUSflags.home || g_jobq_count;
+    
+    if ((0 == len) || (len % 4) || (len > 4 * NUM_VZ)) return (E_FRAME_CRC);
+    if (queue && (g_jobq_count + len / 4 > JOBQ_SIZE)) return (E_JOBQ_FULL);
+
+    for (uint8_t i = 0; i < len; i += 4)    // check all entries
+    {
+        vz = data[i];
+        pos = data[i + 1];
+        mAx10 = (int16_t) (data[i + 2] | (data[i + 3] << 8));
+        if ((0 == vz) || (vz > NUM_VZ)) return (E_VZ_RANGE);
+        if (pos > 100) return (E_SET_POS_RANGE);
+        if ((mAx10 <= 0) || (mAx10 > 2000)) return (E_MA_MAX);
+        if (!queue && !(g_STATUSflags.ref & (1 << (vz - 1)))) return (E_NO_REFERENCE);
+    }
+
+    if (queue)
+    {
+        for (uint8_t i = 0; i < len; i += 4)    // append as jobs
+        {
+            job_push(JOB_MOVE, data[i], data[i + 1], 
+                     (int16_t) (data[i + 2] | (data[i + 3] << 8)));
+        }
+    }
+    else
+    {
+        for (uint8_t i = 0; i < len; i += 4)    // store all entries
+        {
+            vz = data[i];
+            g_setpos[vz] = data[i + 1];
+            g_mAx10_max[vz] = (int16_t) (data[i + 2] | (data[i + 3] << 8));
+            mask |= (uint8_t) (1 << (vz - 1));
+        }
+        g_STATUSflags.pend |= mask;
+        g_STATUSflags.move = 1;
+    }
+
+    mask = g_STATUSflags.pend;
+    frame_send(FRAME_MOVE, &mask, 1);
+    return (0);
+
+} // frame_move ()
+
+
+/** @brief Sends the status frame (binary equivalent of "Status:..."). \n
+ *  Payload (13 bytes): position[1..4] (uint8), g_mAx10 (int16),
+ *  g_STATUSflags (uint16), g_vbemf_sum[g_vz] (int32), g_jobq_count (uint8).
+ *  The values are saved as reference for frame_push().
+ *  @param  type:   FRAME_STATUS (response) or FRAME_STATUS_PUSH (unsolicited)
+ */
+static void frame_status (uint8_t type)
+{
+    uint8_t     data[13];
+    int16_t     mAx10 = g_mAx10;
+    uint16_t    status = g_STATUSflags.v;
+    int32_t     vbemf_sum = g_vbemf_sum[g_vz];
+
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
+    {
+        data[i - 1] = push_position[i] = g_position[i];
+    }
+    push_status = status;
+    push_overcurr = g_ERRORflags.OVER_CURR;
+    push_tick   = g_timer_ms;
+    push_jobs   = g_jobq_count;
+
+    data[4]  = (uint8_t) mAx10;
+    data[5]  = (uint8_t) (mAx10 >> 8);
+    data[6]  = (uint8_t) status;
+    data[7]  = (uint8_t) (status >> 8);
+    data[8]  = (uint8_t) vbemf_sum;
+    data[9]  = (uint8_t) (vbemf_sum >> 8);
+    data[10] = (uint8_t) (vbemf_sum >> 16);
+    data[11] = (uint8_t) (vbemf_sum >> 24);
+    data[12] = g_jobq_count;
+
+    frame_send(type, data, sizeof(data));
+
+} // frame_status ()
+
+/**
+ End of File
+ */
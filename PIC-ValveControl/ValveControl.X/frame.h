@@ -0,0 +1,51 @@
+/**
+ *  @file frame.h
+ *  @brief Declarations for module frame.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ *  - Protocol version 2: unsolicited status frames (FRAME_STATUS_PUSH)
+ *  - Multi-zone move (FRAME_MOVE_REQ)
+ *  - Protocol version 3: status frame with the number of waiting jobs (13 bytes)
+ */
+#ifndef _FRAME_H
+#define	_FRAME_H
+
+// data type, constant and macro definitions
+
+/*  Binary frame (all multi byte values little endian):
+ *  SYNC | TYPE | LEN | DATA[LEN] | CRC16 (low, high)
+ *  The CRC-16/CCITT (poly 0x1021, init 0xFFFF) is computed over TYPE, LEN and DATA.
+ */
+#define FRAME_SYNC      0xA5    /* first byte of a binary frame */
+#define FRAME_MAXDATA   32      /* max. payload bytes (LEN) */
+#define FRAME_OVERHEAD  5       /* SYNC, TYPE, LEN, CRC16 */
+#define FRAME_VERSION   3       /* protocol version (response to "Frame?") */
+
+#define HEARTBEAT_MS    10000   /* [ms] max. interval of unsolicited status frames */
+
+/// Frame types (requests from ESP < 0x80 <= responses from PIC)
+enum FrameTypes {
+    FRAME_STATUS_REQ  = 0x01,   //!< request status (no data)
+    FRAME_MOVE_REQ    = 0x02,   //!< move 1..NUM_VZ zones (4 bytes each: vz, setpos, mAx10 (int16))
+    FRAME_STATUS      = 0x81,   //!< status (13 bytes, see frame_status())
+    FRAME_STATUS_PUSH = 0x82,   //!< unsolicited status (same layout as FRAME_STATUS)
+    FRAME_MOVE        = 0x83,   //!< move accepted (1 byte: pending zones, bit 0 = vz1)
+    FRAME_ERROR       = 0xFF,   //!< error response (1 byte: errno)
+};
+
+// global variables
+extern volatile bool    g_frame_mode;   // binary frames negotiated by ESP
+
+// function prototypes
+extern uint16_t frame_crc16 (uint16_t crc, uint8_t data);
+extern void     frame_interpreter (volatile uint8_t *buf, uint8_t count);
+extern void     frame_push (uint8_t state);
+extern void     frame_send (uint8_t type, const uint8_t *data, uint8_t len);
+
+#endif	/* _FRAME_H */
+
@@ -6,6 +6,10 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Non-blocking read of the INA219: ina219_start() starts the transfer and
+ *   returns at once, the I2C1RX interrupt collects the bytes (ina219_rx()).
+ *   The register pointer of the INA219 is set once (init_ina219()).
  * 2024-02-13 v0.7.2
  * - 1 ms delay() in ina219_read() replaced by negative value to indicate error.
  * 2023-10-17 V0.1
@@ -16,6 +20,10 @@
 #include "main.h"
 #include "i2c.h"
 
+// *** private variables
+static volatile uint8_t     ina_nrx;    ///< bytes received by ina219_rx()
+static volatile uint16_t    ina_rxval;  ///< bytes received (MSB first)
+
 
 /** @brief Initializes the I2C module.
  *  - CLK: 400 kHz
@@ -174,6 +182,53 @@ void ina219_write (uint8_t ina219reg, int16_t value)
 } // ina219_write()
 
 
+/**	@brief Starts reading 2 bytes from the INA219 and returns at once (no
+ *  waiting, no delay). The INA219 keeps its register pointer, so the register
+ *  set by the last ina219_reg() or ina219_write() is read (INA219_SHUNT, see
+ *  init_ina219()). The host hardware issues Start, address, 2 x receive, NACK
+ *  and Stop by itself, the I2C1RX interrupt collects the bytes (ina219_rx()).
+ *  Exec time a few µs, the transfer takes ca. 70 µs (@SCL 400 kHz).
+ *  @return false:  bus busy (previous transfer still in progress), not started
+ */
+bool ina219_start (void)
+{
+    if (!I2C1STAT0bits.BFRE) return (false);    // bus not free
+
+    I2C1STAT1bits.TXWE = 0;     // Clear Transmit Write Error Status
+    I2C1PIRbits.PCIF = 0;
+    if (I2C1STAT1bits.RXBF) ina_rxval = I2C1RXB;    // Clear rxbuf
+    I2C1STAT1 = 0;              // clear error status
+    ina_nrx = 0;
+    
+    I2C1CNTL = 0x02;            // Count register
+    I2C1CNTH = 0x00;
+    PIE7bits.I2C1RXIE = 1;      // receive interrupt (see ina219_rx())
+
+    // Transmit the INA's I2C address (0x40 << 1) + READ: starts the transfer
+    I2C1TXB  = I2C_ADDR_INA219 + I2C_READ;
+
+    return (true);
+
+} // ina219_start()
+
+
+/**	@brief Takes a received byte of the transfer started by ina219_start().
+ *  Call from the I2C1RX interrupt (reading I2C1RXB clears the flag).
+ *  @param  value:  register content (set when the 2nd byte is received)
+ *  @return true:   transfer complete, *value is valid
+ */
+bool ina219_rx (int16_t *value)
+{
+    ina_rxval = (uint16_t) ((ina_rxval << 8) | I2C1RXB);    // MSB first
+    if (++ina_nrx < 2) return (false);
+
+    PIE7bits.I2C1RXIE = 0;      // done (the host sends NACK + Stop)
+    *value = (int16_t) ina_rxval;
+    return (true);
+
+} // ina219_rx()
+
+
 // *** private function bodies
 
 
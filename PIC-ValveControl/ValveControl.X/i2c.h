@@ -6,6 +6,8 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */ 
 /*  Change Log:
+ *  2026-10-16 v0.9
+ *  - Non-blocking read of the INA219 (ina219_start(), ina219_rx())
  *  2023-11-23 V0.6
  *  - First issue
  */
@@ -22,6 +24,10 @@
 
 #define I2C_ADDR_INA219     0x80
 
+#define INA219_CONFIG       0x00    /* INA219 register: configuration */
+#define INA219_SHUNT        0x01    /* INA219 register: shunt voltage (1 LSB = 10 µV = 0.1 mA) */
+//#define INA219_AVG_CONFIG   0x39CF  /* configuration: shunt ADC averages 2 samples (1.06 ms) */
+
 // function prototypes
 extern void     i2c_idle (void);
 extern void     i2c_init (void);
@@ -32,6 +38,8 @@ extern void     i2c_stop (void);
 extern int16_t  ina219_read (void);
 extern void     ina219_reg (uint8_t ina216reg);
 extern void     ina219_write (uint8_t ina216reg, int16_t value);
+extern bool     ina219_start (void);
+extern bool     ina219_rx (int16_t *value);
 
 #endif	/* _I2C_H */
 
@@ -5,6 +5,14 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /* Change Log:
+ * 2026-10-16 v0.9
+ * - Positions, references and learned parameters restored from the EEPROM
+ *   journal (journal_restore()).
+ * - DMA1 / DMA2 enabled for UART1 (uart_init()).
+ * - init_ina219() sets the register pointer of the INA219 once (after the I2C
+ *   module has been enabled).
+ * - TMR2 (monostable, started by the H-bridge OFF edge) triggers the back EMF
+ *   conversion BEMF_SETTLE_US later (init_timer2(), see daq_vbemf_arm()).
  * 2024-01-20 v0.7
  * - PWM is now generated by the 16 bit PWM module (CCP/PWM is hogging TMR2).
  *   PWM1 slice1 is used to drive the H-bridges, slice2 falling edge invokes 
@@ -74,15 +82,20 @@
 
 #include <xc.h>             /* XC8 General Include File */
 #include "main.h"
+#include "daq.h"
 #include "i2c.h"
 #include "init.h"
 #include "interrupt.h"
+#include "uart.h"
+#include "journal.h"
 
 /* Macro to disable Bootlaoder after first flashing
  * by initializing EEPROM[0] with 0x00.  */
 __EEPROM_DATA(0x00,0xFF, 0xFF,0xFF, 0xFF,0xFF, 0xFF,0xFF);  
 
 // *** data type, constant and macro definitions
+#define T2RST_PWM1S1P1  0x03    /* TMR2 external reset source: PWM1S1P1_OUT (datasheet: T2RST) */
+
 // *** global variables
 // *** private variables
 // *** private function prototypes
@@ -100,13 +113,15 @@ void init_system (void)
 
     init_timer0();          // TMR0: 1 ms system clock (used for timeouts etc.)    
     i2c_init();             // I2C: 400 kHz, current sensor module INA216 
-    init_ina219();          // using defaults only
     
     init_fvr();             // fixed voltage reference (measure VDD)
     init_pwm1_16bit();      // PWM to run the motor driver module
+    init_timer2();          // TMR2: back EMF sample after H-bridge OFF
     init_uart1();
+    uart_init();            // DMA: RX and TX ring buffers
 
     I2C1CON0bits.EN = 1;    // enable the I2C module
+    init_ina219();          // defaults, register pointer: shunt voltage
     
 /// - Read Device Information Area (DIA)
     NVMADR = 0x2C0032;          // @ADC FVR1 voltage for 2x setting (in mV)
@@ -120,12 +135,15 @@ void init_system (void)
     NVMCON0bits.GO = 1;         // start word read
     while (NVMCON0bits.GO);     // wait for the read operation to complete
     FVRC2X = NVMDAT;            // 0x0814 = 2068 (Beispiel Eval-Board: +0,98 %)    
+
+/// - Restore positions and references (EEPROM journal)
+    journal_restore();
      
 /// - Initialize Interrupts
     interrupt_initialize();  // Enable Priority Vectors, set high/low priorities
     
     // PIR4bits.U1RXIF = 0;   // U1RXIF is read only
-    PIE4bits.U1RXIE = 1;      // enable RX INT
+    // (U1RX / U1TX trigger DMA, no interrupts, see uart.c)
     
     interrupt_GlobalLowEnable();    // Enables low-priority INTs (if GIE is set)
     interrupt_GlobalHighEnable();   // Enables all high and low priority INTs    
@@ -161,6 +179,9 @@ void init_fvr (void)
  *     resolution, 320-mV shunt full-scale range (PGA = /8), 32-V bus full-scale 
  *     range, and continuous conversion of shunt and bus voltage. \n
  * => Without programming, current is measured by reading the shunt voltage.</i>
+ * - The register pointer is set to the shunt voltage once, ina219_start() reads
+ *   it without rewriting the pointer.
+ * - INA219_AVG_CONFIG (optional) lets the shunt ADC average 2 samples.
  * 
  * \verbatim
  * Hex Register          POR       Type
@@ -175,6 +196,10 @@ void init_fvr (void)
 void init_ina219 (void)
 {
     // ina219_write(0x05, 10240);  // Calibration register (test)
+#ifdef INA219_AVG_CONFIG
+    ina219_write(INA219_CONFIG, INA219_AVG_CONFIG);
+#endif
+    ina219_reg(INA219_SHUNT);   // kept for all reads (ina219_start())
 
 } // init_ina219 ()
 
@@ -286,10 +311,10 @@ void init_pin_manager (void)
 void init_pmd (void)
 {
     PMD0 = 0b00111010;  // Disable FOSC, FVR, HLVD, CRC, SCAN, -, CLKR, IOC
-    PMD1 = 0b00111000;  // Disable CMP1, ZCD, SMT1, TMR4/TMR3/TMR2/-/TMR0
+    PMD1 = 0b00110000;  // Disable CMP1, ZCD, SMT1, TMR4/TMR3/-/-/TMR0
     PMD2 = 0b01100001;  // Disable CCP1, CWG1, DSM1, NCO1, ACT, DAC1, ADC, CMP2?
     PMD3 = 0b00110110;  // Disable UART2/1, SPI2/1, I2C1, PWM3/2/1
-    PMD4 = 0b11111111;  // Disable DMA3/2/2, CLC4/4/2/1, UART3,
+    PMD4 = 0b10011111;  // Disable DMA3, CLC4/3/2/1, UART3 (DMA2/1: UART1)
     PMD5 = 0b00000111;  // Disable OPA1, DAC2, DMA4    
 } // init_pmd ()
 
@@ -363,6 +388,32 @@ init_timer0 (void)
 } // init_timer0 ()
 
 
+/** @brief Initializes Timer 2 to trigger the back EMF conversion.
+ *  - Monostable, started by the falling edge of PWM1S1P1_OUT (H-bridge OFF)
+ *  - Period BEMF_SETTLE_US (4 µs clock), its postscaled output triggers the 
+ *    ADC, when armed by daq_vbemf_arm() (ADACT)
+ *  - No interrupt
+ */
+void 
+init_timer2 (void) 
+{
+    T2CONbits.ON = 0;           // TIMERx stop during setup
+    T2TMR = 0x00;               // TIMERx counter reset
+    T2CLKCONbits.CS = 1;        // TIMERx clock source is FOSC/4 (4 MHz)
+    T2HLTbits.PSYNC = 1;        // prescaler output synchronized to FOSC/4
+    T2HLTbits.CKSYNC = 1;       // ON bit synchronized to the timer clock
+    T2HLTbits.MODE = 0b10010;   // monostable: starts on falling edge of ERS
+    T2RST = T2RST_PWM1S1P1;     // ERS: PWM1S1P1_OUT (falling edge = H-bridge OFF)
+    T2CONbits.CKPS = 0b100;     // TIMERx prescaler 1:16 (4 µs)
+    T2CONbits.OUTPS = 0;        // TIMERx postscaler 1:1   
+    T2PR = BEMF_SETTLE_US / 4 - 1;  // period = BEMF_SETTLE_US
+    PIR3bits.TMR2IF = 0;        // clear interrupt flag bit
+    PIE3bits.TMR2IE = 0;        // (ADC trigger only)
+    T2CONbits.ON = 1;           // TIMERx ON (waits for the edge)
+    
+} // init_timer2 ()
+
+
 /** @brief Initializes UART1 for communication with the ESP8266 D1-mini.
  *  - RXD = RC2     RXD/TXD from PIC's point of view
  *  - TxD = RB5
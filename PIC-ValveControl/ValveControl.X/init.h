@@ -5,6 +5,8 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /*  Change Log:
+ * 2026-10-16 v0.9
+ *  - init_timer2(): trigger of the back EMF conversion
  * 17.10.2023 V0.1
  *  - First issue
  */
@@ -39,6 +41,7 @@ void init_pmd (void);
 void init_pwm1_16bit (void);
 void init_system (void);
 void init_timer0 (void);
+void init_timer2 (void);
 void init_uart1 (void);
 
 #endif	/* _INIT_H */
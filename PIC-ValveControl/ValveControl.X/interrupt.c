@@ -5,6 +5,25 @@
  *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
  */
 /*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - U1RX_isr() also assembles binary frames (see frame.c).
+ * - PWM1_isr() multiplexes the H-bridges of concurrently running zones and
+ *   reads current and back EMF of the solo zone (see motor.c).
+ * - The back EMF of a solo zone is weighted by the periods it has been driven
+ *   since its last sample (g_vbemf_sum[] is the position estimator's input),
+ *   also in single zone mode (periods without sample, ADC in use).
+ * - The unfiltered back EMF is passed to the stall detection (motor_bemf(),
+ *   called by daq_process()).
+ * - No more delay in PWM1_isr(): it only arms the ADC (daq_vbemf_arm()), the 
+ *   conversion is triggered by TMR2 BEMF_SETTLE_US after H-bridge OFF and 
+ *   the result is processed by ADT_isr().
+ * - No more waiting for the INA219 in PWM1_isr(): it only starts the transfer
+ *   (ina219_start()), the current is processed by I2C1RX_isr().
+ * - U1RX_isr() replaced by DMA (uart.c): no interrupt per received char,
+ *   DMA1SCNT_isr() continues sending the TX ring.
+ * - I2C1RX_isr() and ADT_isr() only capture the raw samples (daq_put_isr()),
+ *   filtering, logging, stall detection and g_vbemf_sum[] are done by the
+ *   main loop (daq_process()).
  * 2024-03-12 v0.8
  * - Added logdata bemf_log[1024] and curr_log[1024], which can be read by ESP.
  * - Added experimental g_vbemf_sum (integral of speed x dt ~ distance?)
@@ -23,29 +42,20 @@
 #include "daq.h"
 #include "init.h"
 #include "i2c.h"
+#include "frame.h"
+#include "motor.h"
+#include "uart.h"
 
 // *** data type, constant and macro definitions
 
 #define IVT1_BASE_ADDRESS   0x0808      /* required with bootloader */
 //#define IVT1_BASE_ADDRESS   0x0008
 
-//#define USE_mAMP_LoPASS     1
-//#define USE_BEMF_LoPASS     1
-
-#define NLoPASS_BEMF        1
-#define NLoPASS_CURR        1
-/*  Low Pass Filter
-    y(k) = a * u(k) + b * y(k-1);       b = 1 - a;
-    y(k) = a * u(k) + y(k-1) - a * y(k-1);
-A very fast implementation of 'a * u(k)' and '- b * y(k-1)' simply shifts 
-the values u(k) and y(k-1) by NLoPASS bit to the right. This results in:
-NLoPASS  1       2       3       4       5
-a:      1/2     1/4     1/8     1/16    1/32    = (1 >> NLoPASS)
-Ts/T:	1.44	3.48	7.49	15.5	31.5    Time Constant / Sample Interval
-*/
-
 // *** global variables
 // *** private variables
+static uint8_t  bemf_vz;        ///< zone of the armed back EMF sample
+static int8_t   bemf_dir;       ///< its direction
+static uint8_t  bemf_weight;    ///< PWM periods represented by the sample
 // *** private function prototypes
 // *** public function bodies
 
@@ -56,11 +66,13 @@ Ts/T:	1.44	3.48	7.49	15.5	31.5    Time Constant / Sample Interval
  Vector |     Source     |  Vector  |    Source   \n
  -------+----------------+----------+---------------------------------
  0x27   | PWM1 Parameter |   0x07   |  IOC  (interrupt on change)
-        |                |   0x1B   |  TMR2 (hogged for PWM)
+        |                |   0x0D   |  ADT  (ADC threshold: back EMF)
+        |                |   0x12   |  DMA1SCNT (UART1 TX ring, see uart.c)
+        |                |   0x1B   |  TMR2 (back EMF trigger, no int.)
         |                |   0x1C   |  TMR1 (wake-up from sleep)
         |                |   0x1E   |  CCP1 (Capture/Compare)
         |                |   0x1F   |  TMR0 (1 ms system clock)
-        |                |   0x20   |  U1RX (UART1 RX)
+        |                |   0x3A   |  I2C1RX (INA219: motor current)
 \endverbatim
  */ 
 
@@ -83,11 +95,14 @@ void interrupt_initialize (void)
      * increasing vector numbers, with 0 being the highest.
      */
     IPR0bits.IOCIP  = 0;    // IOCI - low priority (#0x07)
+    IPR1bits.ADTIP  = 0;    // ADTI - low priority (#0x0D)
+    IPR2bits.DMA1SCNTIP = 0;    // DMA1SCNT - low priority (#0x12)
     IPR3bits.TMR2IP = 0;    // TMR2 - low priority (#0x1B)
     IPR3bits.TMR1IP = 0;    // TMR1 - low priority (#0x1C)
     IPR3bits.CCP1IP = 0;    // CCP1 - low priority (#0x1E)
     IPR3bits.TMR0IP = 0;    // TMR0 - low priority (#0x1F)
     IPR4bits.U1TXIP = 0;    // U1RX - low priority (#0x20)
+    IPR7bits.I2C1RXIP = 0;  // I2C1RX - low priority (#0x3A)
     
 } // interrupt_initialize()
 
@@ -107,36 +122,26 @@ default_isr (void)
 
 /** @brief  Handles the PWM1 parameter interrupts. \n
  *  We use two sources of PWM1 interrupts:
- *  - on the right flank of slice2 (after settling of motor current): read Imot.
- *  - on the right flank of slice1 (H-bridge turned off): read Back EMF.
+ *  - on the right flank of slice2 (after settling of motor current): start
+ *    reading Imot (see I2C1RX_isr()).
+ *  - on the right flank of slice1 (H-bridge turned off): arm the ADC for the
+ *    Back EMF (converted BEMF_SETTLE_US later, see ADT_isr()).
+ *  While several zones run at once (g_mux_zones), the H-bridges of the next
+ *  period are mapped on the right flank of slice1 and the Back EMF is read
+ *  in solo periods only (see motor.c).
  */
 void __interrupt (irq(IRQ_PWM1), base(IVT1_BASE_ADDRESS), high_priority)
 PWM1_isr (void)
 {
-    int16_t     mAmps;
-    uint16_t    uk;
+    uint8_t     vz = g_vz;
+    int8_t      dir = g_dir;
             
     // cause of interrupt: slice 1 parameter 2?
     if (PWM1GIRbits.S1P2IF)     // 2 ms after H-bridge ON
     {
         PWM1GIRbits.S1P2IF = 0; // clear interrupt flag
         
-        ina219_reg(1);          // exec time ca. 49 µs (@SCL 400 kHz)
-        mAmps  = ina219_read(); // exec time ca. 72 µs (@SCL 400 kHz)
-        if (mAmps < 0) mAmps = 0;   // offset may cause negative readings ??
-
-#ifdef USE_mAMP_LoPASS
-        g_mAx10 += (mAmps - g_mAx10) >> NLoPASS_CURR;    // is usually > 0
-#else
-        g_mAx10 = mAmps;
-#endif
-        if(g_ns_curr < LOGSIZE)
-        {
-            g_curr_log[g_ns_curr++] = (uint8_t)(g_mAx10 >> 2);
-        }  
-#ifdef TEST_mAMPS2DAC
-        DAC1DATL = (uint8_t) (g_mAx10 >> 2);    // current monitor (16 -> 8 bit)
-#endif
+        ina219_start();         // exec time a few µs, see I2C1RX_isr()
     } // slice 1 parameter 2
 
 
@@ -146,40 +151,68 @@ PWM1_isr (void)
     if (PWM1GIRbits.S1P1IF)     // immediately after H-bridge OFF
     {
         PWM1GIRbits.S1P1IF = 0; // clear interrupt flag
-        
-        __delay_us(400);     // allow vbemf to stabilize
-        /** @todo  This 400 µs delay can cause overrun in the UART!
-         * At 4800 Bd one char is received every 260 µs. 
-         * Generate a synchronized PWM to get a perfect timing!
-         */
-        
-        uk = daq_vbemf(g_vz);   // Exec time ca. 100 µs
-        
-#ifdef USE_BEMF_LoPASS
-        // see: PIC datasheet 40.5.6 Low-Pass Filter Mode and microchip AN2749
-        g_vbemf += (uk - g_vbemf) >> NLoPASS_BEMF;  // is usually > 0
-#else
-        g_vbemf = uk;
-#endif
-        // data logger: save g_vbemf into bemf_log[]
-        if(g_ns_bemf < LOGSIZE)
+
+        if (g_mux_zones)        // concurrent zones (see motor.c)
         {
-            g_vbemf_log[g_ns_bemf++] = (uint8_t)(g_vbemf >> 4);
+            vz  = g_mux_solo;   // zone of the ending period (0: all zones)
+            dir = g_mux_dir[vz];
+            motor_mux_isr();    // map the H-bridges of the next period
+            if (0 == vz) goto _exit;    // Back EMF of a single zone only
         }
+        else if (vz) motor_period_isr(vz);  // single zone: every period driven
         
-#ifdef TEST_VBEMF2DAC
-        // monitor VBEMF (16 -> 8 bit) - requires DACout routed to a pin
-        DAC1DATL = (uint8_t) (g_vbemf >> 4);
-#endif
-        // sum up speed
-        if      (g_dir > 0) g_vbemf_sum[g_vz] += g_vbemf;
-        else if (g_dir < 0) g_vbemf_sum[g_vz] -= g_vbemf;      
+        // TMR2 has been started by this edge and triggers the conversion
+        // after BEMF_SETTLE_US (vbemf stabilized)
+        if (daq_vbemf_arm(vz))
+        {
+            bemf_vz = vz;
+            bemf_dir = dir;
+            // PWM periods represented by this sample
+            bemf_weight = motor_weight_isr(vz);
+        }
         
     } // slice 1 parameter 1
+
+_exit:
+    NOP();
     
 } // PWM1_isr ()
 
 
+/** @brief  Handles the INA219 receive interrupt: the current read started by
+ *  PWM1_isr() (or by the idle state) is complete after the 2nd byte.
+ *  - captures the raw current and the solo zone of this period (processed 
+ *    by daq_process() in the main loop)
+ */
+void __interrupt (irq(IRQ_I2C1RX), base(IVT1_BASE_ADDRESS), low_priority)
+I2C1RX_isr (void)
+{
+    int16_t     mAmps;
+
+    if (!ina219_rx(&mAmps)) return;     // (MSB received)
+
+    daq_put_isr(PIE4bits.PWM1IE ? SAMPLE_CURR : SAMPLE_CURR_IDLE, 
+                g_mux_solo, 0, 0, (uint16_t) mAmps);
+
+} // I2C1RX_isr ()
+
+
+/** @brief  Handles the ADC threshold interrupt: the back EMF burst armed by
+ *  PWM1_isr() is done (see daq_vbemf_arm()).
+ *  - captures the raw back EMF with zone, direction and weight of the 
+ *    period (processed by daq_process() in the main loop)
+ */
+void __interrupt (irq(IRQ_ADT), base(IVT1_BASE_ADDRESS), low_priority)
+ADT_isr (void)
+{
+    PIR1bits.ADTIF = 0;         // clear interrupt flag
+
+    // average of the burst, ADC released
+    daq_put_isr(SAMPLE_BEMF, bemf_vz, bemf_dir, bemf_weight, daq_vbemf_read());
+    
+} // ADT_isr ()
+
+
 /** @brief  Handles all IOC events. \n
  *  We currently don't use any IOC interrupt. Just reset the flags.
  */
@@ -225,54 +258,15 @@ TMR2_isr (void)
 } // TMR2_isr()
 
 
-/** @brief  Handles UART receive events.
- *  - Interrupt when receiving data from ESP via the UART
- *  - Stores chars in g_rx232_buf[]
- *  - Sets flag g_rs232_request = 1 after detection of CR or LF.
+/** @brief  DMA1 (UART1 TX) has sent its part of the TX ring.
+ *  - Starts the next part (see uart.c)
  */
-void __interrupt (irq(IRQ_U1RX), base(IVT1_BASE_ADDRESS), low_priority)
-U1RX_isr (void)
+void __interrupt (irq(IRQ_DMA1SCNT), base(IVT1_BASE_ADDRESS), low_priority)
+DMA1SCNT_isr (void)
 {
-    uint8_t  ch;    // received ascii char
-
-    // PIR4bits.U1RXIF = 0;    // U1RXIF cannot be cleared by software
-
-    if (U1ERRIRbits.RXFOIF || U1ERRIRbits.FERIF) 
-    {   // overrun or framing error?
-        U1ERRIRbits.RXFOIF = U1ERRIRbits.FERIF = 0;
-        ch = U1RXB;            
-        init_uart1();               // reset serial port
-    }
-    else 
-    {  // valid char received, save to buffer, check if CR
-        ch = U1RXB;
-        if (ch == '\r' || ch == '\n')  
-        {
-            ch = 0;
-            if (g_rx232_count > 1)  
-            {
-                g_rs232_request = 1;
-                PIE4bits.U1RXIE = 0;    // disable further U1RX interrupts
-            }                           // until cmd has been processed
-            else    // ignore leading CRLF
-            {
-                goto _exit;
-            }
-        } // EOL received
-        if (g_rx232_count < sizeof(g_rx232_buf)) 
-        {
-            g_rx232_buf[g_rx232_count++] = ch;    // save to buffer
-        }
-        else    // buffer overflow, flush RS232 buf
-        {
-            for (uint8_t i = 0; i < sizeof(g_rx232_buf); i++) g_rx232_buf[i] = 0;
-            g_rx232_count = 0;
-        }
-    } // valid char    
-_exit:
-    NOP();
+    uart_tx_isr();
 
-} // U1RX_isr()
+} // DMA1SCNT_isr()
 
 
 // *** private function bodies
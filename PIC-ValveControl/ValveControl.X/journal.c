@@ -0,0 +1,291 @@
+/**
+ * @file journal.c
+ *  @brief  Positions, references and learned parameters kept in the EEPROM
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  Without the journal, a reset loses all reference bits and every zone has
+ *  to be homed (up to 2 minutes each). The data EEPROM holds a journal of
+ *  JOURNAL_SLOTS records (JOURNAL_t: positions, g_STATUSflags.ref, g_ms_tick[],
+ *  g_vdd_tick[], g_duty_tick[], g_bemf_full[], sequence number and CRC-16):
+ *  - journal_poll() (main loop) compares the state with the last record and
+ *    writes a new record into the next slot (round robin: wear levelling),
+ *    when it has changed. One byte per call, bytes which are already equal
+ *    are skipped, so the main loop never waits for the EEPROM.
+ *  - Zones in motion (g_STATUSflags.vz, g_mux_zones) are recorded without
+ *    reference: a record is written at the start and at the end of a move,
+ *    a power loss during a move requires a home run of this zone only.
+ *  - journal_restore() (init_system()) takes the valid record (CRC, version)
+ *    with the highest sequence number. A record, which has been interrupted
+ *    by a power loss, fails the CRC check, the previous one is taken.
+ *  EEPROM endurance (100k cycles per byte) x JOURNAL_SLOTS: ca. 200,000 moves.
+ *
+ *  The parameter table (param.c) is kept in a single record (PARAMREC_t at
+ *  PARAM_BASE), written by journal_poll() the same way, when a parameter has
+ *  changed ("Param:", "Profile:"). Parameters are set rarely, so there is
+ *  no wear levelling. An interrupted record fails the CRC check, then the
+ *  defaults are taken.
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ * - Parameter record (param.c)
+ * - Duty of the calibration run (g_duty_tick[])
+ */
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stddef.h>
+#include <string.h>
+#include "main.h"
+#include "frame.h"
+#include "motor.h"
+#include "param.h"
+#include "journal.h"
+
+// *** data type, constant and macro definitions
+#define NVM_READ_BYTE   0x00    /* NVMCON1bits.CMD: read byte */
+#define NVM_WRITE_BYTE  0x03    /* NVMCON1bits.CMD: write byte */
+
+// *** global variables
+
+// *** private variables
+static JOURNAL_t    jr_last;        ///< last record (written or in progress)
+static JOURNAL_t    jr_snap;        ///< present state (journal_poll())
+static uint8_t      jr_slot = JOURNAL_SLOTS - 1;    ///< slot of jr_last
+static uint8_t      jr_ix = sizeof(JOURNAL_t);      ///< next byte to write (sizeof: idle)
+static PARAMREC_t   pr_last;        ///< last parameter record (written or in progress)
+static PARAMREC_t   pr_snap;        ///< present parameters (journal_poll())
+static uint8_t      pr_ix = sizeof(PARAMREC_t);     ///< next byte to write (sizeof: idle)
+
+// *** private function prototypes
+static void     journal_snapshot (JOURNAL_t *rec);
+static void     param_snapshot (PARAMREC_t *rec);
+static uint16_t journal_crc (const void *rec, uint8_t len);
+static bool     ee_update (uint24_t adr, const void *rec, uint8_t *ix, uint8_t len);
+static uint8_t  ee_read (uint24_t adr);
+static void     ee_write (uint24_t adr, uint8_t data);
+
+// *** public function bodies
+
+/** @brief Restores the positions, references and learned parameters from the
+ *  newest valid record of the journal and the parameter table from the
+ *  parameter record. Call once from init_system() (before the interrupts are
+ *  enabled). Without a valid record the defaults are kept.
+ *  The back EMF integral of a referenced, calibrated zone is set according
+ *  to its position (see motor_position()).
+ */
+void journal_restore (void)
+{
+    bool        found = false;
+
+    for (uint8_t slot = 0; slot < JOURNAL_SLOTS; slot++)
+    {
+        uint24_t    adr = JOURNAL_BASE + (uint24_t) slot * sizeof(JOURNAL_t);
+        uint8_t     *p = (uint8_t *) &jr_snap;
+
+        for (uint8_t i = 0; i < sizeof(JOURNAL_t); i++) p[i] = ee_read(adr + i);
+
+        if (jr_snap.version != JOURNAL_VERSION) continue;
+        if (jr_snap.crc != journal_crc(&jr_snap, offsetof(JOURNAL_t, crc))) continue;
+        if (found && ((int16_t) (jr_snap.seq - jr_last.seq) <= 0)) continue;
+
+        jr_last = jr_snap;
+        jr_slot = slot;
+        found = true;
+    }
+
+    if (found)
+    {
+        g_STATUSflags.ref = jr_last.ref;
+        for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+        {
+            if ((0 == jr_last.ms_tick[vz - 1]) ||       // (0: g_tick_ms)
+                ((jr_last.ms_tick[vz - 1] >= 10) && (jr_last.ms_tick[vz - 1] <= 1000)))
+            {
+                g_ms_tick[vz] = jr_last.ms_tick[vz - 1];
+                g_vdd_tick[vz] = jr_last.vdd_tick[vz - 1];
+                if ((jr_last.duty_tick[vz - 1] >= DUTY_MIN) && (jr_last.duty_tick[vz - 1] <= DUTY_MAX))
+                {
+                    g_duty_tick[vz] = jr_last.duty_tick[vz - 1];
+                }
+            }
+            if (jr_last.bemf_full[vz - 1] > 0) g_bemf_full[vz] = jr_last.bemf_full[vz - 1];
+            if (!(jr_last.ref & (1 << (vz - 1)))) continue;
+
+            g_position[vz] = g_setpos[vz] = jr_last.position[vz - 1];
+            g_vbemf_sum[vz] = g_bemf_full[vz] * g_position[vz] / 100;
+        }
+    }
+    else journal_snapshot(&jr_last);    // (defaults: nothing to write)
+
+    for (uint8_t i = 0; i < sizeof(PARAMREC_t); i++) ((uint8_t *) &pr_last)[i] = ee_read(PARAM_BASE + i);
+    if ((pr_last.version == PARAM_VERSION) &&
+        (pr_last.crc == journal_crc(&pr_last, offsetof(PARAMREC_t, crc))))
+    {
+        for (uint8_t i = 0; i < NUM_PARAM; i++) param_set(i, pr_last.value[i]);    // (range checked)
+    }
+    param_snapshot(&pr_last);           // (values out of range: defaults kept)
+    pr_last.crc = journal_crc(&pr_last, offsetof(PARAMREC_t, crc));
+
+} // journal_restore ()
+
+
+/** @brief Writes a new record, when the state (or a parameter) has changed
+ *  since the last record. Call on every pass of the main loop: writes (at
+ *  most) one byte per call and returns at once, while the EEPROM is busy.
+ */
+void journal_poll (void)
+{
+    if (NVMCON0bits.GO) return;         // byte write in progress
+
+    // record in progress: next byte
+    if (ee_update(JOURNAL_BASE + (uint24_t) jr_slot * sizeof(JOURNAL_t), &jr_last, &jr_ix, sizeof(JOURNAL_t))) return;
+    if (ee_update(PARAM_BASE, &pr_last, &pr_ix, sizeof(PARAMREC_t))) return;
+
+    journal_snapshot(&jr_snap);
+    jr_snap.seq = jr_last.seq;
+    jr_snap.crc = jr_last.crc;
+    if (memcmp(&jr_snap, &jr_last, sizeof(JOURNAL_t)))
+    {
+        jr_snap.seq++;
+        jr_snap.crc = journal_crc(&jr_snap, offsetof(JOURNAL_t, crc));
+        jr_last = jr_snap;
+        if (++jr_slot >= JOURNAL_SLOTS) jr_slot = 0;
+        jr_ix = 0;                      // (written by the next calls)
+        return;
+    }
+
+    param_snapshot(&pr_snap);
+    if (memcmp(pr_snap.value, pr_last.value, sizeof(pr_last.value)))
+    {
+        pr_snap.crc = journal_crc(&pr_snap, offsetof(PARAMREC_t, crc));
+        pr_last = pr_snap;
+        pr_ix = 0;                      // (written by the next calls)
+    }
+
+} // journal_poll ()
+
+
+/** @brief Completes the journal (blocking, some 100 ms at most). Call
+ *  before a software reset.
+ */
+void journal_flush (void)
+{
+    do
+    {
+        journal_poll();
+    } while (NVMCON0bits.GO || (jr_ix < sizeof(JOURNAL_t)) || (pr_ix < sizeof(PARAMREC_t)));
+
+} // journal_flush ()
+
+
+// *** private function bodies
+
+/** @brief Takes the present state. Zones in motion are recorded without
+ *  reference and position.
+ *  @param  rec:    record (seq and crc are not set)
+ */
+static void journal_snapshot (JOURNAL_t *rec)
+{
+    uint8_t     moving = g_STATUSflags.vz | g_mux_zones;
+
+    rec->version = JOURNAL_VERSION;
+    rec->ref = g_STATUSflags.ref & (uint8_t) ~moving;
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        rec->position[vz - 1] = (rec->ref & (1 << (vz - 1))) ? g_position[vz] : 0;
+        rec->ms_tick[vz - 1] = g_ms_tick[vz];
+        rec->vdd_tick[vz - 1] = g_vdd_tick[vz];
+        rec->duty_tick[vz - 1] = g_duty_tick[vz];
+        rec->bemf_full[vz - 1] = g_bemf_full[vz];
+    }
+
+} // journal_snapshot ()
+
+
+/** @brief Takes the parameter table (param_get()).
+ *  @param  rec:    record (crc is not set)
+ */
+static void param_snapshot (PARAMREC_t *rec)
+{
+    rec->version = PARAM_VERSION;
+    for (uint8_t i = 0; i < NUM_PARAM; i++) rec->value[i] = param_get(i);
+
+} // param_snapshot ()
+
+
+/** @brief Returns the CRC-16/CCITT of a record.
+ *  @param  rec:    record
+ *          len:    bytes before its crc
+ */
+static uint16_t journal_crc (const void *rec, uint8_t len)
+{
+    uint16_t        crc = 0xFFFF;
+    const uint8_t   *p = (const uint8_t *) rec;
+
+    for (uint8_t i = 0; i < len; i++) crc = frame_crc16(crc, p[i]);
+    return (crc);
+
+} // journal_crc ()
+
+
+/** @brief Writes the next byte of a record in progress, which differs from
+ *  the EEPROM (equal bytes are skipped).
+ *  @param  adr:    EEPROM address of the record
+ *          rec:    record
+ *          ix:     next byte to write (len: done)
+ *          len:    sizeof(record)
+ *  @return true:   a byte write has been started
+ */
+static bool ee_update (uint24_t adr, const void *rec, uint8_t *ix, uint8_t len)
+{
+    while (*ix < len)
+    {
+        uint24_t    a = adr + *ix;
+        uint8_t     data = ((const uint8_t *) rec)[(*ix)++];
+
+        if (ee_read(a) != data)
+        {
+            ee_write(a, data);
+            return (true);
+        }
+    }
+    return (false);
+
+} // ee_update ()
+
+
+/** @brief Reads a byte of the data EEPROM (no write may be in progress). */
+static uint8_t ee_read (uint24_t adr)
+{
+    NVMADR = adr;
+    NVMCON1bits.CMD = NVM_READ_BYTE;
+    NVMCON0bits.GO = 1;             // (completes immediately)
+    while (NVMCON0bits.GO);
+    return (NVMDATL);
+
+} // ee_read ()
+
+
+/** @brief Starts writing a byte of the data EEPROM (NVMCON0bits.GO is cleared
+ *  by the hardware when done).
+ */
+static void ee_write (uint24_t adr, uint8_t data)
+{
+    bool        gieh = INTCON0bits.GIEH;
+
+    NVMADR = adr;
+    NVMDATL = data;
+    NVMCON1bits.CMD = NVM_WRITE_BYTE;
+    interrupt_GlobalHighDisable();  // (the unlock sequence must not be interrupted)
+    NVMLOCK = 0x55;
+    NVMLOCK = 0xAA;
+    NVMCON0bits.GO = 1;
+    if (gieh) interrupt_GlobalHighEnable();
+
+} // ee_write ()
+
+/**
+ End of File
+ */
@@ -0,0 +1,46 @@
+/**
+ *  @file journal.h
+ *  @brief Declarations for module journal.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ *  - Parameter record (PARAM_BASE, see param.h)
+ *  - JOURNAL_VERSION 2: duty of the calibration run (duty_tick[]), 4 slots
+ */
+#ifndef _JOURNAL_H
+#define	_JOURNAL_H
+
+// data type, constant and macro definitions
+
+#define JOURNAL_BASE    (EEPROM_BASE + 0x10)    /* EEPROM[0]: bootloader flag, [1 .. 7]: __EEPROM_DATA */
+#define JOURNAL_SLOTS   4       /* records in the journal (wear levelling, 256 bytes EEPROM) */
+#define JOURNAL_VERSION 2       /* layout of JOURNAL_t (records of other versions are ignored) */
+
+/// Record of the journal (46 bytes, EEPROM)
+typedef struct {
+    uint8_t     version;                //!< JOURNAL_VERSION
+    uint16_t    seq;                    //!< sequence number (newest record: highest)
+    uint8_t     ref;                    //!< g_STATUSflags.ref of the zones at rest
+    uint8_t     position[NUM_VZ];       //!< g_position[1 .. NUM_VZ] (valid if referenced)
+    uint16_t    ms_tick[NUM_VZ];        //!< g_ms_tick[1 .. NUM_VZ]
+    uint16_t    vdd_tick[NUM_VZ];       //!< g_vdd_tick[1 .. NUM_VZ]
+    uint8_t     duty_tick[NUM_VZ];      //!< g_duty_tick[1 .. NUM_VZ]
+    int32_t     bemf_full[NUM_VZ];      //!< g_bemf_full[1 .. NUM_VZ]
+    uint16_t    crc;                    //!< CRC-16/CCITT of the bytes above
+} JOURNAL_t;
+
+#define PARAM_BASE      (JOURNAL_BASE + JOURNAL_SLOTS * sizeof(JOURNAL_t))  /* PARAMREC_t (0xC8 .. 0xDE) */
+
+// global variables
+
+// function prototypes
+extern void     journal_restore (void);
+extern void     journal_poll (void);
+extern void     journal_flush (void);
+
+#endif	/* _JOURNAL_H */
+
@@ -25,6 +25,61 @@
  */
 
 /* Change Log:
+ * 2026-10-16 v0.9
+ * - Added binary framed protocol with CRC (frame.c), negotiated by "Frame?".
+ *   Binary frames are dispatched by cmd_interpreter() to frame_interpreter().
+ * - Status frames are pushed to ESP on change and as heartbeat (frame_push()).
+ * - Multi-zone move: moves are queued per zone in g_STATUSflags.pend (set by "Move:" or
+ *   FRAME_MOVE_REQ) and executed one after the other by state_idle / state_move.
+ * - A new set position for the active zone is taken over by state_move without
+ *   returning to idle (retarget). A change of direction stops the motor for 
+ *   REVERSE_MS first.
+ * - Concurrent multi-zone move (motor.c, state_multi): "Budget:mAx10,n" lets up 
+ *   to n zones run at once within a total current budget. n = 1 (default): 
+ *   one zone after the other (state_move).
+ * - Job queue (job_push(), job_next()): "Home:" and "HomeAll:" queue home runs,
+ *   "Move:" and FRAME_MOVE_REQ are queued while a home run is active or jobs
+ *   are waiting (instead of E_HOMEING_ACTIVE). state_idle starts the next jobs
+ *   as soon as no home run or move is in process. Status? reports the number
+ *   of waiting jobs.
+ * - Position estimator (motor.c): home runs from a known position calibrate 
+ *   the back EMF integral of 100 % travel per zone (g_bemf_full[]), then
+ *   state_move and state_multi take the position from g_vbemf_sum[] instead of
+ *   the time driven. "Bemf?" / "Bemf:vz,full" read / set the calibration.
+ * - Calibration run ("Calib:vz,mAx10", state_calib): closed end stop - open end
+ *   stop - closed end stop. Learns the tick period of the zone (g_ms_tick[], 
+ *   replaces MSperTICK), the VDD at calibration (g_vdd_tick[], the tick period
+ *   is scaled by VDD) and the back EMF integral of 100 % travel. 
+ *   VDD is measured every VDD_MS while no motor runs (the ADC is left to the
+ *   back EMF samples), a move uses the VDD measured before its start.
+ *   "Calib?" reports the last run, "Tick?" / "Tick:vz,ms[,vdd[,duty]]" the periods.
+ * - Motion profiles (motor.c, "Profile:"): the duty ramps up after each start
+ *   (soft start, over current blanked unless twice the limit) and drops before
+ *   the target. ms_per_tick() is scaled by the duty (relative to the duty 
+ *   of the calibration run, g_duty_tick[]).
+ * - Stall detection (motor_stall()): over current with collapsed back EMF is an
+ *   end stop after 2 PWM periods, over current without collapse (start-up 
+ *   spike) still needs 12 periods.
+ * - The motor current is read without waiting (ina219_start(), I2C1RX_isr()).
+ * - UART1 is serviced by DMA (uart.c): uart_poll() assembles the received 
+ *   commands, responses are queued in a TX ring. The log dump waits for free
+ *   space in the ring instead of the shift register.
+ * - Added command "Baud:rate" (negotiation up to 500000 Bd, see uart.c).
+ * - cmd_interpreter() looks up the command token in cmd_table[] instead of up
+ *   to 20 strstr() scans, one handler per command. Parameters are parsed by
+ *   fmt_parse(), responses built by fmt_dec() / fmt_hex() (fmt.c): sprintf(),
+ *   sscanf() and printf() are no longer linked. "Xxx:" and "Xxx?" have
+ *   separate handlers (cmd_xxx(), cmd_xxx_query()), an invalid "Budget:" is
+ *   an error (formerly a query).
+ * - The current and back EMF samples are processed in the main loop 
+ *   (daq_process(): filter, data logger, stall detection, g_vbemf_sum[]), the
+ *   ISRs only capture them into the sample ring (see daq.c).
+ * - Positions, references and learned parameters are kept in an EEPROM 
+ *   journal (journal.c): restored after a reset, no home runs needed.
+ * - Parameter table (param.c): "Param?" / "Param:ix,value" read / set the 
+ *   motion parameters at runtime (default tick period g_tick_ms, g_home_s, 
+ *   g_overcurr_n, max. duty, motion profile, data logger decimation), kept in
+ *   the EEPROM. g_ms_tick[] = 0: the zone is not calibrated (g_tick_ms).
  * 2024-02-13 v0.8.1
  * - Status? now returns g_vbemf_sum[g_vz] instead of g_vbemf_sum[1].
  * 2024-02-13 v0.8
@@ -56,7 +111,6 @@
  */
 
 #include <xc.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pic18f16q41.h>
@@ -66,6 +120,12 @@
 #include "daq.h"
 #include "i2c.h"
 #include "init.h"
+#include "frame.h"
+#include "motor.h"
+#include "uart.h"
+#include "fmt.h"
+#include "journal.h"
+#include "param.h"
 
 // *** data type, constant and macro definitions
 
@@ -74,10 +134,33 @@ enum states {
     state_idle = 0, //!< default state (no commands pending)
     state_home,     //!< homing of selected axis (close direction)
     state_move,     //!< move selected axis
+    state_multi,    //!< move several axes at once (motor.c)
+    state_calib,    //!< calibration run of selected axis (end stop to end stop)
 };
 
+/// Phases of the calibration run (state_calib)
+enum CalPhases {
+    CAL_CLOSE = 0,  //!< to the closed end stop
+    CAL_OPEN,       //!< to the open end stop (measured)
+    CAL_BACK,       //!< back to the closed end stop (measured)
+};
+
+/// Entry of the job queue (see job_push())
+typedef struct {
+    uint8_t     type;       //!< JobTypes
+    uint8_t     vz;         //!< valve zone [1 .. NUM_VZ]
+    uint8_t     pos;        //!< set position (JOB_MOVE)
+    int16_t     mAx10;      //!< current limit / 0.1 mA
+} JOB_t;
+
+/// Entry of the command table (see cmd_interpreter())
+typedef struct {
+    const char  *token;     //!< command incl. ':', '?' or '!'
+    int8_t      (*handler) (const char *arg, char *out);    //!< arg: parameters, out: response
+} CMD_t;
+
 // *** global variables
-const char  *g_version = "v0.8.1";    ///< Software version
+const char  *g_version = "v0.9";      ///< Software version
 
 
 uint16_t    FVRA2X;     ///< DIA: @ADC FVR1 voltage for 2x setting (in mV)
@@ -91,7 +174,7 @@ static void timer1_config(void);
 
 volatile uint8_t    g_rx232_buf[48];    ///< RS232 RX buffer (> sizeof(S1-record)!
 volatile uint8_t    g_rx232_count;      ///< counts buffered RX chars
-volatile uint8_t    g_tx232_buf[48];    ///< RS232 TX buffer
+volatile uint8_t    g_tx232_buf[56];    ///< RS232 TX buffer
 
 volatile uint8_t    g_rs232_request;    ///< new RS232 request received from ESP 
 volatile uint8_t    g_rs232_response;   ///< response pending (not yet sent)
@@ -102,6 +185,14 @@ volatile ERRORflags_t   g_ERRORflags;    ///< error flags
 volatile uint16_t   g_timer_ms;     ///< incremented every 1 ms by TMR0 isr
 volatile bool       g_tovfl_ms;     ///< g_timer_ms > 0xFFFF
 
+uint8_t             g_jobq_count;            ///< number of waiting jobs (job queue)
+uint16_t            g_ms_tick[NUM_VZ + 1];   ///< time [ms] per 1 % travel (calibration run, 0: g_tick_ms)
+uint16_t            g_vdd_tick[NUM_VZ + 1];  ///< VDD [0.01 V] of g_ms_tick[] (0: not compensated)
+uint8_t             g_duty_tick[NUM_VZ + 1] = { DUTY_MAX, DUTY_MAX, DUTY_MAX, DUTY_MAX, DUTY_MAX }; ///< [%] duty of g_ms_tick[]
+uint16_t            g_tick_ms = MSperTICK;   ///< time [ms] per 1 % travel of uncalibrated zones (param.c)
+uint8_t             g_home_s = TIMEOUThome;  ///< timeout [s] of home and calibration runs (param.c)
+uint8_t             g_overcurr_n = OVERCURRcount;   ///< over current samples to stop a move (param.c)
+
 volatile uint8_t    g_vz;                    ///< selected vz  {(0), 1 - NUM_VZ}
 volatile uint8_t    g_setpos[NUM_VZ + 1];    ///< set position {(0), 1 - NUM_VZ}
 volatile uint8_t    g_position[NUM_VZ + 1];  ///< position     {0 .. 100%}
@@ -126,33 +217,138 @@ volatile uint16_t   g_ns_curr;
 // *** static variables
 static  uint8_t     main_state = 0;     ///< main: state machine
 static  uint16_t    last_tick;          ///< timer value at last PWM start
+static  uint16_t    t_reverse;          ///< timer value at last change of direction
+static  uint16_t    t_ramp;             ///< timer value at start from standstill (profile)
+static  int8_t      pwm_dir;            ///< direction of the last set_pwm()
 static  uint8_t     n_overcurr;         ///< counts overcurrent events
 static  uint16_t    ix_logdata = 0;     ///< index to transmit logdata to ESP
+static  JOB_t       jobq[JOBQ_SIZE];    ///< job queue (ring buffer)
+static  uint8_t     jobq_head;          ///< index of the next job
+
+static  uint8_t     cal_vz;             ///< zone of the calibration run (0: none)
+static  uint8_t     cal_phase;          ///< CalPhases
+static  uint16_t    cal_tms;            ///< timer value of the last pass
+static  uint32_t    cal_ms;             ///< [ms] driven in this stroke
+static  uint32_t    cal_ms_open;        ///< [ms] stroke time closed -> open
+static  int32_t     cal_mAx10_sum;      ///< integral of the motor current [0.1 mA x ms]
+static  int32_t     cal_vbemf_sum;      ///< integral of the back EMF [ADC raw x ms]
+static  struct {                        ///< result of the last calibration run ("Calib?")
+    uint8_t     vz;                     //!< zone
+    uint16_t    ms_tick;                //!< [ms] per 1 % travel
+    int16_t     mAx10;                  //!< average motor current / 0.1 mA
+    uint16_t    vbemf;                  //!< average back EMF (ADC raw)
+    uint16_t    vdd;                    //!< VDD [0.01 V]
+} cal_result;
 
 // *** private function prototypes
 static void     cmd_interpreter (void);
+static void     job_next (void);
 static bool     over_current (uint8_t vz);
 static void     set_pwm (uint8_t vz, int8_t dir);
+static void     set_duty (int8_t dir, uint8_t dist);
+static int8_t   cmd_status (const char *arg, char *out);
+static int8_t   cmd_move (const char *arg, char *out);
+static int8_t   cmd_home (const char *arg, char *out);
+static int8_t   cmd_homeall (const char *arg, char *out);
+static int8_t   cmd_version (const char *arg, char *out);
+static int8_t   cmd_frame (const char *arg, char *out);
+static int8_t   cmd_budget (const char *arg, char *out);
+static int8_t   cmd_budget_query (const char *arg, char *out);
+static int8_t   cmd_bemf (const char *arg, char *out);
+static int8_t   cmd_bemf_query (const char *arg, char *out);
+static int8_t   cmd_calib (const char *arg, char *out);
+static int8_t   cmd_calib_query (const char *arg, char *out);
+static int8_t   cmd_tick (const char *arg, char *out);
+static int8_t   cmd_tick_query (const char *arg, char *out);
+static int8_t   cmd_profile (const char *arg, char *out);
+static int8_t   cmd_profile_query (const char *arg, char *out);
+static int8_t   cmd_param (const char *arg, char *out);
+static int8_t   cmd_param_query (const char *arg, char *out);
+static int8_t   cmd_baud (const char *arg, char *out);
+static int8_t   cmd_baud_query (const char *arg, char *out);
+static int8_t   cmd_setpos (const char *arg, char *out);
+static int8_t   cmd_max_mA (const char *arg, char *out);
+static int8_t   cmd_logdata (const char *arg, char *out);
+static int8_t   cmd_bootload (const char *arg, char *out);
+
+/// Commands and queries of the ESP (most frequent first, see cmd_interpreter())
+static const CMD_t  cmd_table[] = {
+    { "Status?",    cmd_status },
+    { "Move:",      cmd_move },
+    { "Home:",      cmd_home },
+    { "HomeAll:",   cmd_homeall },
+    { "Version?",   cmd_version },
+    { "Frame?",     cmd_frame },
+    { "Budget:",    cmd_budget },
+    { "Budget?",    cmd_budget_query },
+    { "Bemf:",      cmd_bemf },
+    { "Bemf?",      cmd_bemf_query },
+    { "Calib:",     cmd_calib },
+    { "Calib?",     cmd_calib_query },
+    { "Tick:",      cmd_tick },
+    { "Tick?",      cmd_tick_query },
+    { "Profile:",   cmd_profile },
+    { "Profile?",   cmd_profile_query },
+    { "Param:",     cmd_param },
+    { "Param?",     cmd_param_query },
+    { "Baud:",      cmd_baud },
+    { "Baud?",      cmd_baud_query },
+    { "SetPos?",    cmd_setpos },
+    { "max_mA?",    cmd_max_mA },
+    { "LogData?",   cmd_logdata },
+    { "Bootload!",  cmd_bootload },
+};
 
 
 // *** public function bodies
 
-/** @brief This function outputs one char to the EUSART and is also the helper 
- *  function for the printf() function. \n
- *  When the TXIF bit is not set within approx. 1 ms, the function returns
- *  and data gets lost.
+/** @brief Appends a job to the job queue. The jobs are started by state_idle
+ *  (job_next()), as soon as no home run or move is in process.
+ *  @param  type:   JOB_HOME or JOB_MOVE
+ *          vz:     valve zone [1 .. NUM_VZ]
+ *          pos:    set position [0 .. 100] (JOB_MOVE)
+ *          mAx10:  current limit / 0.1 mA
+ *  @return 0 or E_JOBQ_FULL
  */
-void putch (char data)
+int8_t job_push (uint8_t type, uint8_t vz, uint8_t pos, int16_t mAx10)
 {
-    for (uint8_t timeout = 20; (0 == PIR4bits.U1TXIF) && (timeout > 0); --timeout)
-    {
-        __delay_us(50);                   
-    }    
-    if (PIR4bits.U1TXIF)
+    JOB_t   *job;
+
+    if (g_jobq_count >= JOBQ_SIZE) return (E_JOBQ_FULL);
+
+    job = &jobq[(jobq_head + g_jobq_count) % JOBQ_SIZE];
+    job->type  = type;
+    job->vz    = vz;
+    job->pos   = pos;
+    job->mAx10 = mAx10;
+    g_jobq_count++;
+
+    return (0);
+
+} // job_push ()
+
+
+/** @brief Returns the time [ms] to move zone vz by 1 % (position update by
+ *  time). The calibrated period g_ms_tick[vz] (else g_tick_ms) is scaled by 
+ *  g_vdd_tick[vz] / VDD
+ *  (motor speed ~ supply voltage), if the VDD of the calibration is known, 
+ *  and by g_duty_tick[vz] / g_duty (motion profile), the duty of the
+ *  calibration run (DUTY_MAX for g_tick_ms).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+uint16_t ms_per_tick (uint8_t vz)
+{
+    uint32_t    ms = g_ms_tick[vz] ? g_ms_tick[vz] : g_tick_ms;
+    uint8_t     duty = g_ms_tick[vz] ? g_duty_tick[vz] : DUTY_MAX;
+
+    if (g_vdd_tick[vz] && (VDD > 0) && (VDD < 999))     // (999: VDD error)
     {
-        U1TXB = data;   // send data
-    }    
-} // putch
+        ms = ms * g_vdd_tick[vz] / VDD;
+    }
+    if (g_duty && (g_duty != duty)) ms = ms * duty / g_duty;
+    return ((uint16_t) ms);
+
+} // ms_per_tick ()
 
 
 /** @brief This is the Main program
@@ -162,6 +358,9 @@ void main(void)
     int16_t     ival16;
     int8_t      diff;
     uint16_t    t_home_ms, t_home_s;
+    uint16_t    tick;
+    uint16_t    dt;
+    uint16_t    t_vdd = 0;
     uint8_t     motor = 0;
        
     interrupt_GlobalHighDisable();    
@@ -195,29 +394,50 @@ void main(void)
     while (1)   // This is the main loop
     {   
         /** Main loop:
-         *  - Measure VDD [0.01 V] (optional battery check) */
-        VDD = daq_vdd();        
+         *  - Measure VDD [0.01 V] (optional battery check) every VDD_MS, not
+         *    while the PWM interrupt samples the back EMF (the ADC is free) */
+        if (!PIE4bits.PWM1IE && ((uint16_t) (g_timer_ms - t_vdd) >= VDD_MS))
+        {
+            t_vdd = g_timer_ms;
+            VDD = daq_vdd();
+        }
 
         /** - Check for requests from ESP via RS232
 		 */        
-        if (g_rs232_request)    // command received from ESP (flag gets set by ISR)?
+        uart_poll();            // assemble chars received by DMA
+        if (g_rs232_request)    // command received from ESP (flag set by uart_poll())?
         {
             cmd_interpreter();  // sets main_state according to command
         }
+
+        /** - Process the current and back EMF samples captured by the ISRs
+         *    (g_mAx10, g_vbemf, data logger, stall detection, g_vbemf_sum[]) */
+        daq_process();
         
         switch(main_state) 
         {
             /** - MOVE command
 			 */
             case state_move:
-                
+                /* g_setpos[g_vz] is read on every pass: a new set position 
+                 * (Move: or FRAME_MOVE_REQ) retargets the running move. */
                 diff = (int8_t) (g_setpos[g_vz] - g_position[g_vz]);
-                if      (diff > 0) g_dir = +1;
+                if (((diff > 0) && (g_dir < 0)) || ((diff < 0) && (g_dir > 0)))
+                {   // reverse: stop motor first
+                    g_dir = 0;
+                    t_reverse = g_timer_ms;
+                }
+                else if ((uint16_t) (g_timer_ms - t_reverse) < REVERSE_MS)
+                {
+                    g_dir = 0;      // motor stopping
+                }
+                else if (diff > 0) g_dir = +1;
                 else if (diff < 0) g_dir = -1;
                 else  // diff == 0 
                 {
                     g_dir = 0;
-                    g_STATUSflags.move = 0;     // position reached
+                    g_STATUSflags.pend &= ~g_STATUSflags.vz;    // position reached
+                    g_STATUSflags.move = (g_STATUSflags.pend != 0); // more zones pending?
                     g_STATUSflags.vz = 0;       // deselect drive
 
 #ifdef TEST_AUTO_RETURN
@@ -242,14 +462,20 @@ void main(void)
                 if (over_current(g_vz))     // check for over current
                 {                           // overrides g_dir if true
                     main_state = state_idle;
-                    g_STATUSflags.move = 0;
+                    g_STATUSflags.pend &= ~g_STATUSflags.vz;    // abort this zone only
+                    g_STATUSflags.move = (g_STATUSflags.pend != 0);
+                    g_STATUSflags.vz = 0;
                 }
 
-                // set PWM outputs according g_vz and moving direction
+                // set duty (motion profile) and PWM outputs according g_vz
+                // and moving direction
+                set_duty(g_dir, (uint8_t) abs(diff));
                 set_pwm(g_vz, g_dir);
 
+                // position from back EMF integral (calibrated zone), else 
                 // run a defined amount of time per tick
-                if ((g_timer_ms - last_tick) > MSperTICK)
+                if (motor_position(g_vz)) last_tick = g_timer_ms;
+                else if ((g_timer_ms - last_tick) > ms_per_tick(g_vz))
                 {   // update position: 1 tick per xxx ms
                     g_position[g_vz] += g_dir;
                     last_tick = g_timer_ms;
@@ -269,19 +495,20 @@ void main(void)
                 }
                 else if (over_current (g_vz))   // end position reached?
                 {
-                    g_position[g_vz] = 0;           // set home position
-                    g_vbemf_sum[g_vz] = 0;          // set home position
+                    motor_home_end(g_vz);           // set home position (calibration)
                     main_state = state_idle;
                     g_STATUSflags.home = 0;         // done
+                    g_STATUSflags.vz = 0;           // deselect drive
                     g_STATUSflags.ref |= (uint8_t) (1 << (g_vz - 1));  // ref set  
                 }              
                 else    // proceed homeing in close direction
                 {
                     g_dir = -1;     // set PWM and outputs for close direction
+                    set_duty(g_dir, 100);
 					set_pwm(g_vz, g_dir);
                 }
                 
-                if ((g_timer_ms - last_tick) > MSperTICK)
+                if ((g_timer_ms - last_tick) > ms_per_tick(g_vz))
                 {   // update position: 1 tick per xxx ms:                    
                     if (g_position[g_vz] > 0) g_position[g_vz] -= 1;
                     else g_position[g_vz] = 99;    // rollover                 
@@ -292,14 +519,120 @@ void main(void)
                 if ((g_timer_ms - t_home_ms) > 1000)
                 {   // count seconds
                     t_home_ms = g_timer_ms;
-                    if ((++t_home_s) > TIMEOUThome) 
+                    if ((++t_home_s) > g_home_s) 
                     {   
                         main_state = state_idle;
                         g_STATUSflags.home = 0;     // abort
+                        g_STATUSflags.vz = 0;
                     }
                 }
                 
                 break;
+
+            /// - CALIBRATION run: closed - open - closed end stop (stroke time)
+            case state_calib:
+                nLED = 0;
+                dt = (uint16_t) (g_timer_ms - cal_tms);
+                cal_tms += dt;
+                if (g_dir && (CAL_CLOSE != cal_phase))
+                {   // measure stroke time, current and back EMF (time weighted)
+                    cal_ms += dt;
+                    cal_mAx10_sum += (int32_t) g_mAx10 * dt;
+                    cal_vbemf_sum += (int32_t) g_vbemf * dt;
+                }
+
+                if ((uint16_t) (g_timer_ms - t_reverse) < REVERSE_MS)
+                {
+                    g_dir = 0;      // motor stopping
+                }
+                else if (over_current(g_vz))    // end stop reached?
+                {
+                    n_overcurr = 0;
+                    t_reverse = g_timer_ms;     // stop before reversing
+                    t_home_ms = g_timer_ms;     // timeout per stroke
+                    t_home_s  = 0;
+                    if (CAL_CLOSE == cal_phase)
+                    {
+                        g_position[g_vz] = 0;
+                        g_vbemf_sum[g_vz] = 0;
+                        cal_ms = 0;
+                        cal_mAx10_sum = cal_vbemf_sum = 0;
+                        cal_phase = CAL_OPEN;
+                    }
+                    else if (CAL_OPEN == cal_phase)
+                    {
+                        g_position[g_vz] = 100;
+                        g_bemf_full[g_vz] = g_vbemf_sum[g_vz];  // (motor stopped)
+                        cal_ms_open = cal_ms;
+                        cal_ms = 0;
+                        cal_phase = CAL_BACK;
+                    }
+                    else    // CAL_BACK: done
+                    {
+                        cal_ms += cal_ms_open;  // both strokes
+                        if (0 == cal_ms) cal_ms = 1;
+                        cal_result.vz    = g_vz;
+                        cal_result.ms_tick = (uint16_t) ((cal_ms + 100) / 200);
+                        cal_result.mAx10 = (int16_t) (cal_mAx10_sum / (int32_t) cal_ms);
+                        cal_result.vbemf = (uint16_t) (cal_vbemf_sum / (int32_t) cal_ms);
+                        cal_result.vdd   = ((VDD > 0) && (VDD < 999)) ? VDD : 0;
+                        if ((cal_result.ms_tick >= 10) && (cal_result.ms_tick <= 1000))
+                        {
+                            g_ms_tick[g_vz]  = cal_result.ms_tick;
+                            g_vdd_tick[g_vz] = cal_result.vdd;
+                            g_duty_tick[g_vz] = g_duty_max;     // (set_duty(): 100 % of the stroke)
+                        }
+                        g_position[g_vz] = 0;
+                        g_vbemf_sum[g_vz] = 0;
+                        g_STATUSflags.ref |= (uint8_t) (1 << (g_vz - 1));  // ref set
+                        g_STATUSflags.home = 0;     // done
+                        g_STATUSflags.vz = 0;
+                        cal_vz = 0;
+                        main_state = state_idle;
+                    }
+                }
+                else g_dir = (CAL_OPEN == cal_phase) ? +1 : -1;
+
+                set_duty(g_dir, 100);
+                set_pwm(g_vz, g_dir);
+
+                // position (display only): time driven in this stroke
+                tick = g_ms_tick[g_vz] ? g_ms_tick[g_vz] : g_tick_ms;
+                if (CAL_OPEN == cal_phase)
+                {
+                    g_position[g_vz] = (uint8_t) ((cal_ms < 100UL * tick) ? cal_ms / tick : 100);
+                }
+                else if (CAL_BACK == cal_phase)
+                {
+                    g_position[g_vz] = (uint8_t) ((cal_ms < 100UL * tick) ? 100 - cal_ms / tick : 0);
+                }
+
+                // abort the calibration run after xx seconds per stroke
+                if ((g_timer_ms - t_home_ms) > 1000)
+                {   // count seconds
+                    t_home_ms = g_timer_ms;
+                    if ((++t_home_s) > g_home_s) 
+                    {   
+                        g_dir = 0;
+                        set_pwm(g_vz, g_dir);
+                        g_STATUSflags.home = 0;     // abort (no reference)
+                        g_STATUSflags.vz = 0;
+                        cal_vz = 0;
+                        main_state = state_idle;
+                    }
+                }
+                break;
+
+            /// - MOVE of several zones at once (see motor.c)
+            case state_multi:
+                nLED = 0;
+                motor_admit();          // start further pending zones
+                if (!motor_run())       // all zones done?
+                {
+                    g_STATUSflags.move = (g_STATUSflags.pend != 0);
+                    main_state = state_idle;
+                }
+                break;
                 
             /** - IDLE (kind of scheduler: check status bits for pending jobs). \n
              *    + For sanity, the IOC INT is disabled and enabled only during 
@@ -326,10 +659,9 @@ void main(void)
                 
                 /* Read motor current via INA219 Shunt Current Register
                  * (1 LSB = 10μV, Rs = 0,1 Ohm => I / 0.1 mA = Us / 10µV).
-                 * Exectime ~171 µs. */
-                ina219_reg(1);              // exec time ca. 49 µs (@SCL 400 kHz)
-                g_mAx10 = ina219_read();    // exec time ca. 72 µs (@SCL 400 kHz)
-                if (g_mAx10 < 0) g_mAx10 = 0;   // offset may cause negative readings
+                 * Non-blocking: I2C1RX_isr() captures the sample, 
+                 * daq_process() sets g_mAx10. */
+                ina219_start();
 
                 n_overcurr = 0;             // reset over_current counter
 
@@ -337,55 +669,114 @@ void main(void)
 //              DAC1DATL = (uint8_t) (g_mAx10 >> 2);    // monitor mAx10
                 DAC1DATL = 0;
 #endif                
-                // valid valve zone selected?              
-                if ((g_vz > 0) && (g_vz <= NUM_VZ))
+                // job queue: next jobs, when no home run or move is in process
+                if (g_jobq_count && !g_STATUSflags.home && !g_STATUSflags.pend)
                 {
-                    if (g_STATUSflags.home)	// home has prioritiy over move
-                    {
-                        g_STATUSflags.ref &= ~(uint8_t) (1 << (g_vz - 1));
-                        g_ns_bemf = 0;    // reset data logger indices
-                        g_ns_curr = 0; 
+                    job_next();
+                }
 
-                        t_home_ms = g_timer_ms; // set start time (for timeout)
-                        t_home_s  = 0;
+                // calibration run
+                if (cal_vz)
+                {
+                    g_vz = cal_vz;
+                    g_ns_bemf = 0;    // reset data logger indices
+                    g_ns_curr = 0; 
+                    cal_phase = CAL_CLOSE;
+                    cal_tms = g_timer_ms;
+                    t_reverse = g_timer_ms - REVERSE_MS;    // no stop pending
+                    t_home_ms = g_timer_ms; // set start time (for timeout)
+                    t_home_s  = 0;
+
+                    main_state = state_calib;
+                }
 
-                        main_state = state_home; // prio
-                    }
-                    
-                    else if (g_STATUSflags.move) 
+                // home runs: several zones at once (see motor.c)
+                else if (g_mux_home)
+                {
+                    g_vz = 0;         // (g_mux_zones are in process)
+                    g_ns_bemf = 0;    // reset data logger indices
+                    g_ns_curr = 0; 
+                    motor_admit();
+
+                    main_state = state_multi;
+                }
+
+                // home has prioritiy over move (valid valve zone selected?)
+                else if (g_STATUSflags.home && (g_vz > 0) && (g_vz <= NUM_VZ))
+                {
+                    g_STATUSflags.ref &= ~(uint8_t) (1 << (g_vz - 1));
+                    g_ns_bemf = 0;    // reset data logger indices
+                    g_ns_curr = 0; 
+
+                    t_home_ms = g_timer_ms; // set start time (for timeout)
+                    t_home_s  = 0;
+
+                    main_state = state_home; // prio
+                }
+
+                // pending moves: several zones at once (see motor.c)
+                else if (g_STATUSflags.move && g_STATUSflags.pend && (g_concurrent > 1))
+                {
+                    g_vz = 0;         // (g_mux_zones are in process)
+                    g_ns_bemf = 0;    // reset data logger indices
+                    g_ns_curr = 0; 
+                    motor_admit();
+
+                    main_state = state_multi;
+                }
+
+                // pending moves: next zone (lowest first)
+                else if (g_STATUSflags.move && g_STATUSflags.pend) 
+                {
+                    for (g_vz = 1; g_vz < NUM_VZ; g_vz++)
                     {
-                        g_ns_bemf = 0;    // reset data logger indices
-                        g_ns_curr = 0; 
-                        
-                        main_state = state_move;
+                        if (g_STATUSflags.pend & (1 << (g_vz - 1))) break;
                     }
+                    g_STATUSflags.vz = (uint8_t) (1 << (g_vz - 1));   // active drive
+                    g_ns_bemf = 0;    // reset data logger indices
+                    g_ns_curr = 0; 
+                    t_reverse = g_timer_ms - REVERSE_MS;    // no stop pending
+
+                    main_state = state_move;
                 }
+                else g_STATUSflags.move = 0;    // (nothing pending)
 
                 if (g_STATUSflags.logdata) 
                 {
-                    if (ix_logdata < LOGSIZE)
+                    if (ix_logdata >= LOGSIZE)
                     {
-                        while (!U1ERRIRbits.TXMTIF) ;  // until shift reg. is empty
-                        sprintf((char *)g_tx232_buf, "%u,%u,%u\n", ix_logdata,
-                            g_vbemf_log[ix_logdata], g_curr_log[ix_logdata]);
-                        ix_logdata++;
-                        printf((char *)g_tx232_buf);    // send data
+                        g_STATUSflags.logdata = 0;  // done
                     }
-                    else
+                    else if (uart_tx_free() >= 16)  // (else: next pass)
                     {
-                        g_STATUSflags.logdata = 0;  // done
+                        char    *p = (char *) g_tx232_buf;
+
+                        p = fmt_dec(p, ix_logdata, ',');
+                        p = fmt_dec(p, g_vbemf_log[ix_logdata], ',');
+                        fmt_dec(p, g_curr_log[ix_logdata], '\n');
+                        ix_logdata++;
+                        uart_puts((char *) g_tx232_buf);    // send data
                     }
                 }
                 
                 if (g_STATUSflags.bootload) 
                 {   // reprogramming via bootload takes ca. 2:30 minutes
-                    while (!U1ERRIRbits.TXMTIF) ;  // until shift reg. is empty
+                    while (!uart_tx_idle()) ;  // until the response is sent
+                    journal_flush();            // (positions kept)
                     RESET();
                 }
                                 
                 last_tick = g_timer_ms;     // reset time reference
                 break;                        
         } // switch
+
+        /** - Push the status to ESP on change (binary frames only)
+         */
+        frame_push(main_state);
+
+        /** - Journal: save positions and references on change (EEPROM)
+         */
+        journal_poll();
             
     } // while()        
     
@@ -394,185 +785,545 @@ void main(void)
 
 
 /** @brief Command Interpreter
+ *  Looks up the command token (up to and including the first ':', '?' or 
+ *  '!') in cmd_table[] and calls its handler. The handlers parse the 
+ *  parameters by fmt_parse() and build the response in g_tx232_buf by 
+ *  fmt_dec() etc. (no sscanf() / sprintf(), see fmt.c).
  *  Commands and Queries:
- *  - Move: vz, setpos, max_mA
- *  - Home: vz, max_mA
+ *  - Move: vz, setpos, max_mA (queued in g_STATUSflags.pend, or in the job 
+ *    queue while a home run is active or jobs are waiting)
+ *  - Home: vz, max_mA (job queue)
+ *  - HomeAll: max_mA [, max_mA move]  home all zones (job queue), then move
+ *    each zone back to its set position (if max_mA move is given)
  *  - max_mA?	Current Limits
  *  - SetPos?	Set positions
- *  - Status?	Detailed status
+ *  - Status?	Detailed status (last value: number of waiting jobs)
  *  - Version?	Version of PIC Firmware
+ *  - Frame?	Negotiate binary frames (response "Frame:<version>")
+ *  - Budget: mAx10, n  total current budget, max. zones at once (Budget? query)
+ *  - Bemf: vz, full    back EMF integral of 100 % travel, 0: time based (Bemf? query)
+ *  - Calib: vz, max_mA calibration run (job queue), Calib? result of the last run
+ *  - Tick: vz, ms [, vdd [, duty]]  time per 1 % travel [at VDD, duty], 0: g_tick_ms (Tick? query)
+ *  - Profile: start, slow, ramp_ms, slow_pct  motion profile (Profile? query)
+ *  - Param: ix, value  parameter table, see param.c (Param? query)
+ *  - Baud: rate      baud rate of the UART, confirmed at the new rate (Baud? query)
  *  - Bootload! Run bootloader
+ *  Binary frames (1st byte FRAME_SYNC) are passed to frame_interpreter().
  */
 static 
 void cmd_interpreter (void)
 {
-    char        *p;
-    uint8_t     u8;
-    unsigned    vz = 0, pos = 0;
-    int16_t     mAx10 = 0;
-    int8_t      error = 0;
-    int16_t     timeout;
+    const char  *p = (const char *) g_rx232_buf;
+    char        *out = (char *) g_tx232_buf;
+    uint8_t     len;
+    int8_t      error = E_UNDEF_CMD;
 
-/// Commands:
-    
-    // STATUS
-    p = strstr((const char *)g_rx232_buf, "Status?");  // STATUS
-    if (p != NULL) 
+    // binary frame (responds by itself)
+    if (FRAME_SYNC == g_rx232_buf[0])
     {
-        sprintf((char *)g_tx232_buf, "Status:%u,%u,%u,%u,%u,0x%04X,0x%08lX\n", 
-            g_position[1], g_position[2], g_position[3], g_position[4],
-            g_mAx10, g_STATUSflags, g_vbemf_sum[g_vz]);
-        goto _done;
+        frame_interpreter(g_rx232_buf, g_rx232_count);
+        goto _flush;
     }
 
+    // command token: skip leading garbage, up to ':', '?' or '!'
+    while (*p && ((*p < 'A') || (*p > 'z'))) p++;
+    for (len = 0; p[len] && (p[len] != ':') && (p[len] != '?') && (p[len] != '!'); len++) ;
+    if (p[len]) len++;      // (including the delimiter)
+
+    for (uint8_t i = 0; i < sizeof(cmd_table) / sizeof(cmd_table[0]); i++)
+    {
+        if (strncmp(cmd_table[i].token, p, len) || cmd_table[i].token[len]) continue;
+        error = cmd_table[i].handler(p + len, out);
+        break;
+    }
+
+    if (error)
+    {
+        fmt_dec(fmt_str(out, "ERROR "), error, '\n');
+    }                
+    uart_puts(out);     // send response
+_flush:
+    g_rs232_request = 0;    // ack flag
+
+    // clear RX buffer (uart_poll() assembles the next command)
+    for (uint8_t i = 0; i < sizeof(g_rx232_buf); i++) g_rx232_buf[i] = 0;
+    g_rx232_count = 0;
     
-    // MOVE
-    p = strstr((const char *)g_rx232_buf, "Move:");  // MOVE
-    if (p != NULL) 
+} // cmd_interpreter ()
+
+
+/** @brief "Status?": positions [1..4], motor current, STATUSflags, back EMF
+ *  integral of the selected zone, number of waiting jobs.
+ *  @param  arg:    parameters (after the token)
+ *          out:    response
+ *  @return 0 or error number
+ */
+static int8_t cmd_status (const char *arg, char *out)
+{
+    out = fmt_str(out, "Status:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++) out = fmt_dec(out, g_position[i], ',');
+    out = fmt_dec(out, g_mAx10, ',');
+    out = fmt_hex(fmt_str(out, "0x"), g_STATUSflags.v, 4, ',');
+    out = fmt_hex(fmt_str(out, "0x"), (uint32_t) g_vbemf_sum[g_vz], 8, ',');
+    fmt_dec(out, g_jobq_count, '\n');
+    return (0);
+
+} // cmd_status ()
+
+
+/** @brief "Move:vz,setpos,mAx10": vz = 0 cancels all moves and waiting jobs.
+ */
+static int8_t cmd_move (const char *arg, char *out)
+{
+    int32_t     v[3];       // vz, pos, mAx10
+    uint8_t     vz;
+
+    if (fmt_parse(arg, v, 3) != 3) return (E_UNDEF_CMD);
+    out = fmt_dec(fmt_str(out, "Move:"), v[0], ',');
+    fmt_dec(fmt_dec(out, v[1], ','), v[2], '\n');
+
+    // vz = 0: deselect all (cancels the waiting jobs too), [1..4] selects drive 1 to 4
+    if (0 == v[0]) 
+    { 
+        g_STATUSflags.move = 0; 
+        g_STATUSflags.pend = 0; 
+        g_jobq_count = 0;
+        return (0); 
+    }
+    if ((v[0] < 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+    if ((v[1] < 0) || (v[1] > 100)) return (E_SET_POS_RANGE);      // [0 .. 100]
+    if ((v[2] <= 0) || (v[2] > 2000)) return (E_SET_POS_RANGE);     // [ .1 .. 200.0]
+    vz = (uint8_t) v[0];
+
+    // home run active or jobs waiting: move after them (reference is checked then)
+    if (g_STATUSflags.home || g_jobq_count)
     {
-        if (g_STATUSflags.home)
-        {
-            error = E_HOMEING_ACTIVE;
-            goto _done;
-        }
-        if (sscanf(p+5, "%u,%u,%d\n", &vz, &pos, &mAx10) == 3)
-        {   // vz = 0: deselect all, [1..4] selects drive 1 to 4
-            if (0 == vz) { g_STATUSflags.move = 0; goto _done; }
-            else if (vz > NUM_VZ) { error = E_VZ_RANGE; goto _done; }
-            
-            g_vz = (uint8_t) vz;  // [1 .. 4] 
+        return (job_push(JOB_MOVE, vz, (uint8_t) v[1], (int16_t) v[2]));
+    }
+    g_setpos[vz] = (uint8_t) v[1];
+    g_mAx10_max[vz] = (int16_t) v[2];
+    
+    // check if reference is set
+    if (!(g_STATUSflags.ref & (1 << (vz - 1)))) return (E_NO_REFERENCE);
 
-            if (pos <= 100) g_setpos[vz] = (uint8_t) pos;  // [0 .. 100]
-            else {  error = E_SET_POS_RANGE; goto _done; }
+    // queue the move, the zone is selected by state_idle
+    g_STATUSflags.pend |= (uint8_t) (1 << (vz - 1));
+    g_STATUSflags.move = 1;              // make move active
+    return (0);
 
-             // [ .1 .. 200.0]
-            if ((mAx10 > 0) && (mAx10 <= 2000))  g_mAx10_max[vz] = mAx10;
-            else {  error = E_SET_POS_RANGE; goto _done; }
-        }
-        sprintf((char *)g_tx232_buf, "Move:%u,%u,%d\n", 
-                                      vz, g_setpos[vz], g_mAx10_max[vz]);
-        
-        // check if reference is set
-        if (g_STATUSflags.ref & (1 << (vz - 1)))
-        {
-            g_STATUSflags.vz = (uint8_t) (1 << (vz - 1));   // active drive
-            g_STATUSflags.move = 1;              // make move active
-        }
-        else error = E_NO_REFERENCE;
-        
-        goto _done;
+} // cmd_move ()
+
+
+/** @brief "Home:vz,mAx10": home run (job queue), vz = 0 clears all references.
+ */
+static int8_t cmd_home (const char *arg, char *out)
+{
+    int32_t     v[2];       // vz, mAx10
+
+    if (fmt_parse(arg, v, 2) != 2) return (E_UNDEF_CMD);
+    fmt_dec(fmt_dec(fmt_str(out, "Home:"), v[0], ','), v[1], '\n');
+
+    // vz = 0: deselect all, [1..4] selects drive 1 to 4
+    if (0 == v[0]) { g_STATUSflags.ref = 0; return (0); }
+    if ((v[0] < 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+    if ((v[1] <= 0) || (v[1] > 1000)) return (E_SET_POS_RANGE);     // [ 0.1 .. 100.0]
+
+    return (job_push(JOB_HOME, (uint8_t) v[0], 0, (int16_t) v[1]));   // started by state_idle
+
+} // cmd_home ()
+
+
+/** @brief "HomeAll:mAx10[,mAx10 move]": home all zones, then (optional) move
+ *  each zone back to its set position.
+ */
+static int8_t cmd_homeall (const char *arg, char *out)
+{
+    int32_t     v[2] = { 0, 0 };    // mAx10 home, mAx10 move
+    uint8_t     n = fmt_parse(arg, v, 2);
+
+    if (0 == n) return (E_UNDEF_CMD);
+    if ((v[0] <= 0) || (v[0] > 1000)) return (E_MA_MAX);
+    if ((n > 1) && ((v[1] <= 0) || (v[1] > 2000))) return (E_MA_MAX);
+    if (g_jobq_count + 2 * NUM_VZ > JOBQ_SIZE) return (E_JOBQ_FULL);
+
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++) job_push(JOB_HOME, vz, 0, (int16_t) v[0]);
+    if (n > 1) for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        job_push(JOB_MOVE, vz, g_setpos[vz], (int16_t) v[1]);
     }
+    out = fmt_dec(fmt_dec(fmt_str(out, "HomeAll:"), v[0], ','), v[1], ',');
+    fmt_dec(out, g_jobq_count, '\n');
+    return (0);
+
+} // cmd_homeall ()
+
+
+/** @brief "Version?": firmware version.
+ */
+static int8_t cmd_version (const char *arg, char *out)
+{
+    fmt_str(fmt_str(fmt_str(out, "Version: "), g_version), "\n");
+    return (0);
 
-    // HOME
-    p = strstr((const char *)g_rx232_buf, "Home:");  // HOME
-    if (p != NULL) 
+} // cmd_version ()
+
+
+/** @brief "Frame?": negotiates binary frames, response: protocol version.
+ */
+static int8_t cmd_frame (const char *arg, char *out)
+{
+    g_frame_mode = true;
+    fmt_dec(fmt_str(out, "Frame:"), FRAME_VERSION, '\n');
+    return (0);
+
+} // cmd_frame ()
+
+
+/** @brief "Budget:mAx10,n": current budget of concurrent moves (motor.c) and
+ *  max. number of zones at once.
+ */
+static int8_t cmd_budget (const char *arg, char *out)
+{
+    int32_t     v[2];       // mAx10, zones
+
+    if (fmt_parse(arg, v, 2) != 2) return (E_UNDEF_CMD);
+    if ((v[0] <= 0) || (v[0] > 8000)) return (E_MA_MAX);        // [0.1 .. 800.0 mA]
+    if ((v[1] <= 0) || (v[1] > NUM_VZ)) return (E_VZ_RANGE);    // [1 .. NUM_VZ] zones
+    g_mAx10_budget = (int16_t) v[0];
+    g_concurrent = (uint8_t) v[1];
+    return (cmd_budget_query(arg, out));
+
+} // cmd_budget ()
+
+
+/** @brief "Budget?": current budget and max. number of zones at once.
+ */
+static int8_t cmd_budget_query (const char *arg, char *out)
+{
+    fmt_dec(fmt_dec(fmt_str(out, "Budget:"), g_mAx10_budget, ','), g_concurrent, '\n');
+    return (0);
+
+} // cmd_budget_query ()
+
+
+/** @brief "Bemf:vz,full": back EMF integral of 100 % travel (motor.c), 
+ *  0: time based position.
+ */
+static int8_t cmd_bemf (const char *arg, char *out)
+{
+    int32_t     v[2];       // vz, full
+
+    if (fmt_parse(arg, v, 2) != 2) return (E_UNDEF_CMD);
+    if ((v[0] <= 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+    if (v[1] < 0) return (E_SET_POS_RANGE);
+    g_bemf_full[(uint8_t) v[0]] = v[1];     // 0: time based position
+    return (cmd_bemf_query(arg, out));
+
+} // cmd_bemf ()
+
+
+/** @brief "Bemf?": back EMF integrals of 100 % travel [1..4].
+ */
+static int8_t cmd_bemf_query (const char *arg, char *out)
+{
+    out = fmt_str(out, "Bemf:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
     {
-        if (sscanf(p+5, "%u,%u\n", &vz, &mAx10) == 2)
-        {   // vz = 0: deselect all, [1..4] selects drive 1 to 4
-            if (0 == vz) { g_STATUSflags.ref = 0; goto _done; }
-            else if (vz > NUM_VZ) { error = E_VZ_RANGE; goto _done; }
+        out = fmt_dec(out, g_bemf_full[i], (i < NUM_VZ) ? ',' : '\n');
+    }
+    return (0);
 
-            g_vz = (uint8_t) vz;  // [1 .. 4]
+} // cmd_bemf_query ()
 
-             // [ 0.1 .. 100.0]
-            if ((mAx10 > 0) && (mAx10 <= 1000))  g_mAx10_max[vz] = mAx10;
-            else { error = E_SET_POS_RANGE; goto _done; }
-        }
-        sprintf((char *)g_tx232_buf, "Home:%d,%d\n", vz, g_mAx10_max[vz]);
-        
-        g_STATUSflags.vz = (uint8_t) (1 << (vz - 1));   // active drive
-        g_STATUSflags.home = 1;    // make home active
-        
-        goto _done;
+
+/** @brief "Calib:vz,mAx10": calibration run (job queue).
+ */
+static int8_t cmd_calib (const char *arg, char *out)
+{
+    int32_t     v[2];       // vz, mAx10
+
+    if (fmt_parse(arg, v, 2) != 2) return (E_UNDEF_CMD);
+    if ((v[0] <= 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+    if ((v[1] <= 0) || (v[1] > 1000)) return (E_MA_MAX);    // [ 0.1 .. 100.0]
+
+    fmt_dec(fmt_dec(fmt_str(out, "Calib:"), v[0], ','), v[1], '\n');
+    return (job_push(JOB_CALIB, (uint8_t) v[0], 0, (int16_t) v[1]));
+
+} // cmd_calib ()
+
+
+/** @brief "Calib?": result of the last calibration run (zone, ms per 1 %, 
+ *  average current, average back EMF, VDD).
+ */
+static int8_t cmd_calib_query (const char *arg, char *out)
+{
+    out = fmt_dec(fmt_str(out, "Calib:"), cal_result.vz, ',');
+    out = fmt_dec(fmt_dec(out, cal_result.ms_tick, ','), cal_result.mAx10, ',');
+    fmt_dec(fmt_dec(out, cal_result.vbemf, ','), cal_result.vdd, '\n');
+    return (0);
+
+} // cmd_calib_query ()
+
+
+/** @brief "Tick:vz,ms[,vdd[,duty]]": time per 1 % travel [at VDD and duty, 
+ *  default DUTY_MAX], ms = 0: not calibrated (g_tick_ms).
+ */
+static int8_t cmd_tick (const char *arg, char *out)
+{
+    int32_t     v[4] = { 0, 0, 0, DUTY_MAX };   // vz, ms, vdd, duty
+
+    if (fmt_parse(arg, v, 4) < 2) return (E_UNDEF_CMD);
+    if ((v[0] <= 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+    if ((v[1] && (v[1] < 10)) || (v[1] > 1000) || (v[2] < 0) || (v[2] > 999)) return (E_SET_POS_RANGE);
+    if ((v[3] < DUTY_MIN) || (v[3] > DUTY_MAX)) return (E_SET_POS_RANGE);
+    g_ms_tick[(uint8_t) v[0]] = (uint16_t) v[1];
+    g_vdd_tick[(uint8_t) v[0]] = (uint16_t) v[2];     // 0: not compensated
+    g_duty_tick[(uint8_t) v[0]] = (uint8_t) v[3];
+    return (cmd_tick_query(arg, out));
+
+} // cmd_tick ()
+
+
+/** @brief "Tick?": time per 1 % travel [1..4] (0: not calibrated).
+ */
+static int8_t cmd_tick_query (const char *arg, char *out)
+{
+    out = fmt_str(out, "Tick:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
+    {
+        out = fmt_dec(out, g_ms_tick[i], (i < NUM_VZ) ? ',' : '\n');
     }
-    
-    
-    // Firmware Version
-    p = strstr((const char *)g_rx232_buf, "Version?");
-    if (p != NULL) 
+    return (0);
+
+} // cmd_tick_query ()
+
+
+/** @brief "Profile:start,slow,ramp_ms,slow_pct": motion profile (motor.c),
+ *  duty at start / near target [%], ramp [ms], slow down [%].
+ */
+static int8_t cmd_profile (const char *arg, char *out)
+{
+    int32_t     v[4];       // start, slow, ramp, pct
+
+    if (fmt_parse(arg, v, 4) != 4) return (E_UNDEF_CMD);
+    if ((v[0] < DUTY_MIN) || (v[0] > DUTY_MAX) || (v[1] < DUTY_MIN) || (v[1] > DUTY_MAX) ||
+        (v[2] < 0) || (v[2] > 5000) || (v[3] < 0) || (v[3] > 100)) return (E_SET_POS_RANGE);
+    g_profile.duty_start = (uint8_t) v[0];
+    g_profile.duty_slow  = (uint8_t) v[1];
+    g_profile.ramp_ms    = (uint16_t) v[2];     // 0: no ramp
+    g_profile.slow_pct   = (uint8_t) v[3];      // 0: no slow down
+    return (cmd_profile_query(arg, out));
+
+} // cmd_profile ()
+
+
+/** @brief "Profile?": motion profile.
+ */
+static int8_t cmd_profile_query (const char *arg, char *out)
+{
+    out = fmt_dec(fmt_dec(fmt_str(out, "Profile:"), g_profile.duty_start, ','), g_profile.duty_slow, ',');
+    fmt_dec(fmt_dec(out, g_profile.ramp_ms, ','), g_profile.slow_pct, '\n');
+    return (0);
+
+} // cmd_profile_query ()
+
+
+/** @brief "Param:ix,value": sets parameter ix (ParamIds, see param.c) within
+ *  its range.
+ */
+static int8_t cmd_param (const char *arg, char *out)
+{
+    int32_t     v[2];       // ix, value
+    int8_t      error;
+
+    if (fmt_parse(arg, v, 2) != 2) return (E_UNDEF_CMD);
+    if ((v[0] < 0) || (v[0] >= NUM_PARAM)) return (E_PARAM_RANGE);
+    error = param_set((uint8_t) v[0], v[1]);
+    if (error) return (error);
+    return (cmd_param_query(arg, out));
+
+} // cmd_param ()
+
+
+/** @brief "Param?": all values in the order of ParamIds.
+ */
+static int8_t cmd_param_query (const char *arg, char *out)
+{
+    out = fmt_str(out, "Param:");
+    for (uint8_t i = 0; i < NUM_PARAM; i++)
     {
-        sprintf((char *)g_tx232_buf, "Version: %s\n", g_version);
-        goto _done;
+        out = fmt_dec(out, param_get(i), (i < NUM_PARAM - 1) ? ',' : '\n');
     }
+    return (0);
+
+} // cmd_param_query ()
+
+
+/** @brief "Baud:rate": baud rate (uart.c), switched after the response. The 
+ *  ESP must confirm it by the same command at the new rate, else 38400 Bd 
+ *  again.
+ */
+static int8_t cmd_baud (const char *arg, char *out)
+{
+    int32_t     baud;
 
-    // Set Positions
-    p = strstr((const char *)g_rx232_buf, "SetPos?");  // STATUS
-    if (p != NULL) 
+    if (fmt_parse(arg, &baud, 1) != 1) return (E_UNDEF_CMD);
+    if (uart_baud((uint32_t) baud)) return (E_BAUD);
+    fmt_dec(fmt_str(out, "Baud:"), baud, '\n');    // (the new rate)
+    return (0);
+
+} // cmd_baud ()
+
+
+/** @brief "Baud?": present baud rate.
+ */
+static int8_t cmd_baud_query (const char *arg, char *out)
+{
+    fmt_dec(fmt_str(out, "Baud:"), (int32_t) uart_baud_rate(), '\n');
+    return (0);
+
+} // cmd_baud_query ()
+
+
+/** @brief "SetPos?": set positions [1..4].
+ */
+static int8_t cmd_setpos (const char *arg, char *out)
+{
+    out = fmt_str(out, "SetPos:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
     {
-        sprintf((char *)g_tx232_buf, "SetPos:%u,%u,%u,%u\n", 
-            g_setpos[1], g_setpos[2], g_setpos[3], g_setpos[4]);
-        goto _done;
-    }    
-
-    // Current Limits
-    p = strstr((const char *)g_rx232_buf, "max_mA?");  // STATUS
-    if (p != NULL) 
+        out = fmt_dec(out, g_setpos[i], (i < NUM_VZ) ? ',' : '\n');
+    }
+    return (0);
+
+} // cmd_setpos ()
+
+
+/** @brief "max_mA?": current limits [1..4].
+ */
+static int8_t cmd_max_mA (const char *arg, char *out)
+{
+    out = fmt_str(out, "max_mA:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++)
     {
-        sprintf((char *)g_tx232_buf, "max_mA:%d,%d,%d,%d\n", 
-            g_mAx10_max[1], g_mAx10_max[2], g_mAx10_max[3], g_mAx10_max[4]);
-        goto _done;
+        out = fmt_dec(out, g_mAx10_max[i], (i < NUM_VZ) ? ',' : '\n');
     }
+    return (0);
+
+} // cmd_max_mA ()
+
 
-    // Log data
-    p = strstr((const char *)g_rx232_buf, "LogData?");  // LOGDATA
-    if (p != NULL) 
-    {   // here we can only acknowledge the command:
-        ix_logdata = 0;
-        sprintf((char *)g_tx232_buf, "LogData:\n");
-        g_STATUSflags.logdata = 1;  // transmit logdata to ESP
-        goto _done;
+/** @brief "LogData?": here we can only acknowledge the command, the log data
+ *  is sent by state_idle.
+ */
+static int8_t cmd_logdata (const char *arg, char *out)
+{
+    ix_logdata = 0;
+    fmt_str(out, "LogData:\n");
+    g_STATUSflags.logdata = 1;  // transmit logdata to ESP
+    return (0);
+
+} // cmd_logdata ()
+
+
+/** @brief "Bootload!": writes 0xFF into EEPROM[0] and reboots (after the 
+ *  response) into the bootloader.
+ */
+static int8_t cmd_bootload (const char *arg, char *out)
+{
+    while (NVMCON0bits.GO) ;  // journal byte write in progress (journal.c)
+    INTCON0bits.GIEH = 0;     // disable INTs
+    NVMADR = EEPROM_BASE + 0x00; // write to EEPROM[0] ...
+    NVMDATL = 0xFF;              // .. 0xFF to enable bootloader
+    NVMCON1bits.CMD = 0x03;
+    NVMLOCK = 0x55;              // unlock EEPROM
+    NVMLOCK = 0xAA;
+    NVMCON0bits.GO = 1;          // perform write
+
+    for (uint8_t timeout = 0; timeout < 20; ++timeout)
+    {
+        if (!NVMCON0bits.GO) break;
+        else __delay_ms(1);
     }
+    NVMCON1bits.CMD = 0;
+    INTCON0bits.GIEH = 1;     // enable INTs (response sent by DMA)
     
-    // Bootloader
-    p = strstr((const char *)g_rx232_buf, "Bootload!");  // UPDATE/BOOTLOAD
-    if (p != NULL) 
-    {   // write 0xFF into EEPROM[0]
-        INTCON0bits.GIEH = 0;     // disable INTs
-        NVMADR = EEPROM_BASE + 0x00; // write to EEPROM[0] ...
-        NVMDATL = 0xFF;              // .. 0xFF to enable bootloader
-        NVMCON1bits.CMD = 0x03;
-        NVMLOCK = 0x55;              // unlock EEPROM
-        NVMLOCK = 0xAA;
-        NVMCON0bits.GO = 1;          // perform write
-
-        for (uint8_t timeout = 0; timeout < 20; ++timeout)
+    fmt_str(out, "Bootload!\n");
+    g_STATUSflags.bootload = 1;    // reboot after acknowledge
+    return (0);
+
+} // cmd_bootload ()
+
+
+/** @brief Starts the next jobs of the job queue. Call from state_idle, when
+ *  no home run or move is in process. Consecutive jobs of the same type are
+ *  started together:
+ *  - JOB_MOVE: the zones are queued in g_STATUSflags.pend (moved one after 
+ *    the other or at once, see g_concurrent). A move of a zone without 
+ *    reference (home run failed) is skipped.
+ *  - JOB_HOME: g_concurrent > 1: the zones are homed at once (g_mux_home, 
+ *    see motor.c), else one home run is started (g_vz, state_home).
+ *  - JOB_CALIB: one calibration run is started (cal_vz, state_calib).
+ */
+static void job_next (void)
+{
+    JOB_t       *job = &jobq[jobq_head];
+    uint8_t     type = job->type;
+    uint8_t     bit;
+
+    while (g_jobq_count && (job->type == type))
+    {
+        bit = (uint8_t) (1 << (job->vz - 1));
+        if (JOB_CALIB == type)
         {
-            if (!NVMCON0bits.GO) break;
-            else __delay_ms(1);
+            if (g_STATUSflags.home) break;  // one at a time
+
+            g_mAx10_max[job->vz] = job->mAx10;
+            g_STATUSflags.ref &= ~bit;
+            cal_vz = job->vz;
+            g_STATUSflags.vz = bit;         // active drive
+            g_STATUSflags.home = 1;         // (includes home runs)
         }
-        NVMCON1bits.CMD = 0;
-        
-        sprintf((char *)g_tx232_buf, "Bootload!\n");
-        g_STATUSflags.bootload = 1;    // reboot after acknowledge
-        
-        goto _done;
-    }        
-    
-/// Command not found:
-    error = E_UNDEF_CMD;
-    //goto _done;
-    
-_done:                
-    if (error)
-    {
-        sprintf((char *)g_tx232_buf, "ERROR %d\n", error);
-    }                
-    printf((char *)g_tx232_buf);    // send response        
-    g_rs232_request = 0;    // ack flag
+        else if (JOB_HOME == type)
+        {
+            if (g_STATUSflags.home && (g_concurrent <= 1)) break;  // one at a time
+
+            g_mAx10_max[job->vz] = job->mAx10;
+            motor_home_start(job->vz);      // (calibration of g_bemf_full)
+            g_STATUSflags.ref &= ~bit;
+            if (g_concurrent > 1) g_mux_home |= bit;
+            else
+            {
+                g_vz = job->vz;
+                g_STATUSflags.vz = bit;     // active drive
+            }
+            g_STATUSflags.home = 1;         // make home active
+        }
+        else if (g_STATUSflags.ref & bit)   // JOB_MOVE
+        {
+            g_setpos[job->vz] = job->pos;
+            g_mAx10_max[job->vz] = job->mAx10;
+            g_STATUSflags.pend |= bit;
+            g_STATUSflags.move = 1;
+        }
+        jobq_head = (jobq_head + 1) % JOBQ_SIZE;
+        g_jobq_count--;
+        job = &jobq[jobq_head];
+    }
 
-    // clear uart shift register and RX buffer
-    for (uint8_t i = 0; i < sizeof(g_rx232_buf); i++) g_rx232_buf[i] = 0;
-    g_rx232_count = 0;
-    for (uint8_t c = 0; PIR4bits.U1RXIF; ) c = U1RXB;   // clr RXB (mainly 0x0A)
-    PIE4bits.U1RXIE = 1;    // re-enable U1RX interrupts
-    
-} // cmd_interpreter ()
+} // job_next ()
 
 
-/** @brief Check for over current (e.g. due to blocked drive)
- *  - Compares actual current g_mAx10 with limit of selected valve zone vz
- *  - On overcurrent, counter n_overcurr gets incremented, else counter is reset
- *  - If counter exceeds 12 (ca. 100 ms), 
+/** @brief Check for over current (e.g. due to blocked drive), once per PWM period
+ *  - Compares actual current g_mAx10 with limit of selected valve zone vz and
+ *    evaluates the back EMF of the same period (motor_stall())
+ *  - End stop (current over the limit, back EMF collapsed for 2 periods) is
+ *    an over current at once
+ *  - Else on overcurrent, counter n_overcurr gets incremented (start-up 
+ *    current blanked during the ramp of the motion profile), else counter 
+ *    is reset
+ *  - On end stop or if counter exceeds g_overcurr_n (PARAM_OVERCURR, 
+ *    default OVERCURRcount), 
  *    - PWM is stopped, g_dir forced to 0
  *    - Error flag OVER_CURR is set
  *  @param  vz: valve zone [0, 1 - 4]
@@ -581,18 +1332,25 @@ _done:
 static bool over_current (uint8_t vz)
 {
     bool result = false;
+    uint8_t stall;
+
+    if ((0 == vz) || (vz > NUM_VZ)) return (false);
+    stall = motor_stall(vz, g_mAx10, g_mAx10_max[vz]);
 
-    if (g_mAx10 > g_mAx10_max[vz])    // if over current
+    if ((STALL_SPIKE == stall) &&     // if over current (start-up current blanked)
+        !(pwm_dir && motor_ramp_blank((uint16_t) (g_timer_ms - t_ramp), g_mAx10, g_mAx10_max[vz])))
     {
-        if (++n_overcurr > 12)        // lasts longer than 100 ms
-        {
-            set_pwm(vz, 0);           // stop pwm
-            g_dir = 0;
-            g_ERRORflags.OVER_CURR = 1;
-            result = true;
-        }
+        if (++n_overcurr > g_overcurr_n) stall = STALL_END; // (default: longer than 100 ms)
+    }
+    else if (STALL_NONE != stall) n_overcurr = 0;  // reset spike counter
+
+    if (STALL_END == stall)           // end stop or persistent over current
+    {
+        set_pwm(vz, 0);               // stop pwm
+        g_dir = 0;
+        g_ERRORflags.OVER_CURR = 1;
+        result = true;
     }
-    else n_overcurr = 0;  // reset spike counter
 
     return (result);
     
@@ -614,6 +1372,8 @@ static void set_pwm (uint8_t vz,    // valve zone [0, 1 - 4]
     {
         __delay_us(50);
     }
+    if ((dir != pwm_dir) && vz && (vz <= NUM_VZ)) motor_weight_reset(vz);  // start / reverse
+    pwm_dir = dir;
     
     switch (vz)   // select vz
     {
@@ -757,6 +1517,24 @@ static void set_pwm (uint8_t vz,    // valve zone [0, 1 - 4]
     } // switch
     
 } // set_pwm()
+
+
+/** @brief Sets the duty of the H-bridges by the motion profile (motor_duty()).
+ *  Call before set_pwm(): a start from standstill restarts the ramp and the
+ *  stall detection.
+ *  @param  dir:    direction [-1, 0, +1] to set
+ *          dist:   [%] distance to the target (100: home or calibration run)
+ */
+static void set_duty (int8_t dir, uint8_t dist)
+{
+    if (dir && !pwm_dir)        // start from standstill
+    {
+        t_ramp = g_timer_ms;
+        motor_stall_reset(g_vz);
+    }
+    motor_pwm_duty(motor_duty((uint16_t) (g_timer_ms - t_ramp), dist));
+
+} // set_duty ()
         
         
 /**
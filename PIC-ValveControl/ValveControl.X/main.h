@@ -7,6 +7,19 @@
 /*  Change Log:
  *  2023-11-23 V0.6
  *  - First issue
+ *  2026-10-16 v0.9
+ *  - Added E_FRAME_CRC and STATUSflags_t.v (binary frames, see frame.c)
+ *  - Added STATUSflags pend (bits 12-15): zones with pending move (multi-zone move)
+ *  - Added job queue (JOBQ_SIZE, JobTypes, job_push()) and E_JOBQ_FULL
+ *  - Added per zone tick period (g_ms_tick[], ms_per_tick()), learned by JOB_CALIB
+ *  - putch() moved to uart.c (TX ring, DMA)
+ *  - Added E_BAUD
+ *  - Added ERRORflags SAMPLE_LOST (sample ring overflow, see daq.c)
+ *  - MSperTICK, TIMEOUThome, OVERCURRcount: defaults of the parameter table
+ *    (g_tick_ms, g_home_s, g_overcurr_n, see param.c), added E_PARAM_RANGE
+ *  - Added g_duty_tick[] (duty of the calibration run, see ms_per_tick())
+ *  - Added VDD_MS (VDD is measured only while no motor runs)
+ *  - TEST_SETREF disabled (the reference flags are restored from the EEPROM, see journal.c)
  */
 #include <stdint.h>     // defines C99 standard types as 'uint8_t' and 'int16_t'
 #include <stdbool.h>    // defines type 'bool' 
@@ -30,12 +43,16 @@
 #define interrupt_GlobalLowDisable()   (INTCON0bits.GIEL = 0)
 
 #define NUM_VZ  4           /* no. of valve zones */
-#define	MSperTICK	100     /* time [ms] to move a motor by 1 % of max. travel */
-#define	TIMEOUThome 120     /* timeout [s] for homeing */
+#define	MSperTICK	100     /* default time [ms] to move a motor by 1 % of max. travel (g_tick_ms) */
+#define	TIMEOUThome 120     /* default timeout [s] for homeing (g_home_s) */
+#define OVERCURRcount 12    /* default over current samples to stop a move (g_overcurr_n) */
+#define REVERSE_MS  100     /* time [ms] to stop a motor before reversing (new set position) */
+#define VDD_MS      100     /* [ms] VDD measuring interval (only while no motor runs) */
+#define JOBQ_SIZE   12      /* capacity of the job queue ("HomeAll:" takes 2 x NUM_VZ) */
 
 #define VBEMF_NO_DIA      1     /* AD conversion without calibration */ 
 
-#define TEST_SETREF       1     /* sets ref position flags for testing */
+//#define TEST_SETREF       1     /* sets ref position flags for testing */
 //#define TEST_AUTO_RETURN  1     /* MOVE auto returns to zero position */
 //#define TEST_DACOUT_A2    1     /* monitor variables via DAC (@RA2 = /LED) */
 //#define TEST_VBEMF2DAC    1     /* output VBEMF to DAC1 */
@@ -47,7 +64,8 @@ typedef union {     // 'low Byte', weak errors: mission may be continued.
     struct {
         uint8_t ref         :4;  //  0-3: vz  referenced
         uint8_t vz          :4;  //  4-7: vz  in process
-        uint8_t             :8;  //  8-15 spare
+        uint8_t             :4;  //  8-11 (see below)
+        uint8_t pend        :4;  // 12-15: vz  move pending (incl. vz in process)
     };
     struct {
         uint8_t ref1        :1;  //  0: vz1 referenced
@@ -62,8 +80,12 @@ typedef union {     // 'low Byte', weak errors: mission may be continued.
         uint8_t home        :1;  //  9: 'home' is executing 
         uint8_t bootload    :1;  // 10: 'bootload' reboot and start bootloader
         uint8_t logdata     :1;  // 11: 'logdata to ESP' is executing
-        uint8_t             :4;  // 12-15 spare
+        uint8_t pend1       :1;  // 12: vz1 move pending
+        uint8_t pend2       :1;  // 13: vz2 move pending
+        uint8_t pend3       :1;  // 14: vz3 move pending
+        uint8_t pend4       :1;  // 15: vz4 move pending
     };
+    uint16_t v;
 } STATUSflags_t;    // token "STATUSbits" reserved by microchip
 
 typedef union {     // 'low Byte', weak errors: mission may be continued.
@@ -71,15 +93,27 @@ typedef union {     // 'low Byte', weak errors: mission may be continued.
         uint8_t CRC         :1;  // 0 Program checksum error 
         uint8_t UNEXP_INT   :1;  // 1 Unexpected interrupt
         uint8_t OVER_CURR   :1;  // 2 Overcurrent during move
-        uint8_t             :5;  // 3-7 spare
+        uint8_t SAMPLE_LOST :1;  // 3 Sample ring overflow (main loop blocked)
+        uint8_t             :4;  // 4-7 spare
     };
     uint8_t v;
 } ERRORflags_t;  
 
+/// Job types of the job queue (see job_push())
+enum JobTypes {
+    JOB_HOME = 1,   //!< home run of one zone
+    JOB_MOVE,       //!< move of one zone (skipped, if the zone has no reference)
+    JOB_CALIB,      //!< calibration run of one zone (closed - open - closed end stop)
+};
+
 enum Errs {     /* ALL errnos must be negative (see adc_read() as example) */
     E_ADC_TIMEOUT     = -127,   // AD converter timeout
 
-    E_HOMEING_ACTIVE  = -6,     // Move command, whereas Home is active
+    E_PARAM_RANGE     = -10,    // parameter index or value out of range
+    E_BAUD            = -9,     // baud rate not supported
+    E_JOBQ_FULL       = -8,     // job queue full
+    E_FRAME_CRC       = -7,     // binary frame: wrong length or CRC
+    E_HOMEING_ACTIVE  = -6,     // Move command, whereas Home is active (obsolete: queued)
     E_NO_REFERENCE    = -5,     // reference not set
     E_UNDEF_CMD       = -4,     // undefined command
     E_MA_MAX          = -3,     // ma_max out of range
@@ -88,7 +122,8 @@ enum Errs {     /* ALL errnos must be negative (see adc_read() as example) */
 };
 
 // function prototypes
-
+extern int8_t job_push (uint8_t type, uint8_t vz, uint8_t pos, int16_t mAx10);
+extern uint16_t ms_per_tick (uint8_t vz);
 
 // global variables
 uint16_t    FVRA2X;
@@ -101,12 +136,20 @@ extern volatile uint8_t    g_rs232_request;
 extern volatile uint8_t    g_rs232_response;
 
 extern volatile uint8_t    g_rx232_buf[48];
-extern volatile uint8_t    g_tx232_buf[48];
+extern volatile uint8_t    g_tx232_buf[56];
 extern volatile uint8_t    g_rx232_count;
 
 extern volatile uint16_t   g_timer_ms;
 extern volatile bool       g_tovfl_ms;
 
+extern uint8_t             g_jobq_count;
+extern uint16_t            g_ms_tick[NUM_VZ + 1];
+extern uint16_t            g_vdd_tick[NUM_VZ + 1];
+extern uint8_t             g_duty_tick[NUM_VZ + 1];
+extern uint16_t            g_tick_ms;
+extern uint8_t             g_home_s;
+extern uint8_t             g_overcurr_n;
+
 extern volatile uint8_t    g_vz;
 extern volatile uint8_t    g_setpos[NUM_VZ + 1]; 
 extern volatile uint8_t    g_position[NUM_VZ + 1];
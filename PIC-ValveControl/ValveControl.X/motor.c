@@ -0,0 +1,668 @@
+/**
+ * @file motor.c
+ *  @brief  Concurrent operation of several motors (multi-zone move)
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  All H-bridges can be fed by the same PWM1S1P1_OUT (PPS), so several zones
+ *  can run at once. The INA219 measures the sum of all motor currents, the
+ *  current of a single zone is measured by time multiplexing: every
+ *  MUX_PERIODS-th PWM period one running zone (round robin) runs alone (solo
+ *  period). Its current and back EMF are measured in this period.
+ *  - motor_admit() starts pending zones (g_STATUSflags.pend, g_mux_home), as long as no
+ *    more than g_concurrent zones run and the sum of their current limits
+ *    (g_mAx10_max[]) fits into g_mAx10_budget.
+ *  - motor_run() sets the direction of each zone, stops it at its target
+ *    position or on a stall (solo samples, mux_stall()), and stops all zones if the
+ *    total current exceeds the budget. A home run (g_mux_home) ends on over
+ *    current (end position) or on timeout.
+ *  - motor_mux_isr() maps the H-bridge inputs for the next PWM period (called
+ *    by PWM1_isr()), motor_sample() takes the current sample (daq_process()).
+ *  The position is dead-reckoned from the PWM periods a zone has actually
+ *  been driven (solo periods of other zones don't count).
+ *  Set by "Budget:mAx10,n" (n = g_concurrent), n = 1: one zone after the
+ *  other by state_move (default).
+ *
+ *  Position estimator: daq_process() integrates the back EMF (~ speed) of the
+ *  driven zone into g_vbemf_sum[] (~ distance, 0 at the closed end stop).
+ *  A home run, which starts at a referenced position of at least CAL_MIN_POS,
+ *  measures the integral of a known travel and calibrates g_bemf_full[] (the
+ *  integral of 100 % travel). Once calibrated, motor_position() derives the 
+ *  position from the integral instead of the time driven, so speed changes
+ *  by VDD, load or temperature no longer cause a position error.
+ *
+ *  Motion profile (g_profile): the duty of the H-bridges ramps from duty_start
+ *  to g_duty_max within ramp_ms after each start and drops to duty_slow within
+ *  slow_pct of the target (motor_duty()). The start-up current spike is no
+ *  over current during the ramp, unless it exceeds twice the limit
+ *  (motor_ramp_blank()). All zones share PWM1, concurrent zones run with the
+ *  lowest duty of their profiles.
+ *
+ *  Stall detection (motor_stall()): a motor running into its end stop draws
+ *  more current AND its back EMF collapses, while at a start-up spike or under
+ *  heavy load the back EMF is still present (or has never been established).
+ *  So a current over the limit with the back EMF below 1/4 of its running
+ *  average is an end stop after STALL_PERIODS samples (16 ms in single zone
+ *  mode), a current over the limit without collapse still needs the long
+ *  confirmation of the callers (over_current(), g_mux_overcurr).
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ * - Concurrent home runs (g_mux_home, set by the job queue in main.c)
+ * - Position estimator from the back EMF integral (g_bemf_full[])
+ * - Motion profiles (g_profile, motor_duty(), motor_pwm_duty())
+ * - Stall detection from current and back EMF (motor_stall(), motor_bemf())
+ * - motor_sample() and motor_bemf() (formerly *_isr()) are called by the main
+ *   loop (daq_process()), g_vbemf_sum[] is read without disabling interrupts
+ * - Max. duty and over current count tunable at runtime (g_duty_max,
+ *   g_mux_overcurr, see param.c)
+ * - The periods of the single zone are counted too (motor_period_isr()), 
+ *   its back EMF is weighted like that of a solo zone (motor_weight_isr())
+ */
+
+#include <xc.h>             /* XC8 General Include File */
+#include <stddef.h>
+#include "main.h"
+#include "motor.h"
+
+// *** data type, constant and macro definitions
+#define PPS_PWM1S1P1    0x0A    /* PPS output source: PWM1S1P1_OUT */
+
+// *** global variables
+volatile uint8_t    g_mux_zones;                ///< zones running concurrently (bit 0 = vz1)
+volatile uint8_t    g_mux_home;                 ///< zones to home, pending or running (bit 0 = vz1)
+volatile int8_t     g_mux_dir[NUM_VZ + 1];      ///< direction per zone [-1, 0, +1]
+volatile int16_t    g_mux_mAx10[NUM_VZ + 1];    ///< motor current per zone (solo period) / 0.1 mA
+volatile uint8_t    g_mux_solo;                 ///< zone running alone in this period (0: all)
+int16_t             g_mAx10_budget = BUDGET_mAx10;  ///< total current budget / 0.1 mA
+uint8_t             g_concurrent = 1;           ///< max. number of zones running at once
+int32_t             g_bemf_full[NUM_VZ + 1];    ///< back EMF integral of 100 % travel (0: not calibrated)
+PROFILE_t           g_profile = { 40, 50, 300, 3 }; ///< motion profile (start, slow, ramp, slow down)
+uint8_t             g_duty = DUTY_MAX;          ///< [%] duty of PWM1 slice 1 (init_pwm1_16bit(): 90 %)
+uint8_t             g_duty_max = DUTY_MAX;      ///< [%] max. duty [DUTY_MIN .. DUTY_MAX] (param.c)
+uint8_t             g_mux_overcurr = MUX_OVERCURR;  ///< solo samples over the limit: over current (param.c)
+
+// *** private variables
+/// PPS registers of the H-bridge inputs (open, close direction) of each zone
+static volatile uint8_t * const pps_open[NUM_VZ + 1]  = { NULL, &RA4PPS, &RC4PPS, &RC7PPS, &RC3PPS };
+static volatile uint8_t * const pps_close[NUM_VZ + 1] = { NULL, &RA5PPS, &RC5PPS, &RB7PPS, &RC6PPS };
+
+static volatile int8_t      mux_mapped[NUM_VZ + 1];     ///< direction driven in this period
+static volatile uint8_t     mux_periods[NUM_VZ + 1];    ///< PWM periods driven (ISR counter)
+static volatile uint8_t     mux_overbudget;             ///< samples over g_mAx10_budget
+static uint8_t              mux_period;                 ///< counts PWM periods to the solo period
+static uint8_t              mux_next;                   ///< last solo zone (round robin)
+
+static uint8_t              mux_counted[NUM_VZ + 1];    ///< mux_periods[] already counted
+static uint16_t             mux_ms[NUM_VZ + 1];         ///< [ms] driven, not yet counted as tick
+static uint8_t              mux_nover[NUM_VZ + 1];      ///< solo samples over the limit
+static uint16_t             mux_trev[NUM_VZ + 1];       ///< timer value at change of direction
+static uint16_t             mux_thome[NUM_VZ + 1];      ///< timer value of the last home second
+static uint8_t              mux_shome[NUM_VZ + 1];      ///< [s] home run duration (timeout)
+static uint16_t             mux_tramp[NUM_VZ + 1];      ///< timer value at start from standstill
+static volatile uint8_t     mux_sampled[NUM_VZ + 1];    ///< mux_periods[] at the last back EMF sample
+static volatile bool        stall_new[NUM_VZ + 1];      ///< new back EMF sample (motor_bemf())
+static volatile uint16_t    stall_vbemf[NUM_VZ + 1];    ///< last back EMF sample (ADC raw)
+static uint16_t             stall_avg[NUM_VZ + 1];      ///< back EMF average while running
+static uint8_t              stall_nrun[NUM_VZ + 1];     ///< samples below the limit (max. STALL_RUN)
+static uint8_t              stall_n[NUM_VZ + 1];        ///< consecutive samples with collapsed back EMF
+
+static int32_t              cal_sum0[NUM_VZ + 1];       ///< g_vbemf_sum[] at the start of the home run
+static uint8_t              cal_pos0[NUM_VZ + 1];       ///< position at the start of the home run (0: unknown)
+
+// *** private function prototypes
+static void     motor_start (uint8_t vz);
+static void     motor_stop (uint8_t vz);
+static uint8_t  mux_stall (uint8_t vz, uint16_t t_run);
+
+// *** public function bodies
+
+/** @brief Starts pending zones (g_STATUSflags.pend and g_mux_home, lowest
+ *  first), which are not yet running. A zone is started, if less than g_concurrent zones are
+ *  running and the sum of the current limits fits into g_mAx10_budget
+ *  (the first zone is always started).
+ */
+void motor_admit (void)
+{
+    uint8_t     n = 0;
+    int16_t     sum = 0;
+
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        if (g_mux_zones & (1 << (vz - 1)))
+        {
+            n++;
+            sum += g_mAx10_max[vz];
+        }
+    }
+
+    for (uint8_t vz = 1; (vz <= NUM_VZ) && (n < g_concurrent); vz++)
+    {
+        if (!((g_STATUSflags.pend | g_mux_home) & (1 << (vz - 1)))) continue;
+        if (g_mux_zones & (1 << (vz - 1))) continue;
+        if (n && (sum + g_mAx10_max[vz] > g_mAx10_budget)) continue;   // later
+
+        motor_start(vz);
+        n++;
+        sum += g_mAx10_max[vz];
+    }
+    g_STATUSflags.vz = g_mux_zones;
+
+} // motor_admit ()
+
+
+/** @brief Runs the zones started by motor_admit(). Call on every pass of the
+ *  main loop (state_multi).
+ *  - updates the positions (1 % per ms_per_tick() driven),
+ *  - stops a zone at its set position (a new set position retargets it,
+ *    a change of direction stops the motor for REVERSE_MS first),
+ *  - stops a zone on over current (g_mux_overcurr solo samples over
+ *    g_mAx10_max[]) and all zones, if the total current exceeds the budget,
+ *  - stops a zone, whose move has been cancelled (pend bit cleared).
+ *  A home run drives the zone in close direction until over current (the
+ *  end position: position 0, reference set) or until g_home_s.
+ *  g_STATUSflags.home is set as long as zones are to be homed.
+ *  @return true: zones are running
+ */
+bool motor_run (void)
+{
+    uint8_t     bit, n;
+    uint8_t     duty = g_duty_max;
+    int8_t      diff;
+    uint16_t    tick, t_run;
+
+    if (mux_overbudget >= MUX_OVERBUDGET)    // total current over budget
+    {
+        g_ERRORflags.OVER_CURR = 1;
+        g_STATUSflags.pend &= ~g_mux_zones;
+        g_mux_home &= ~g_mux_zones;
+        for (uint8_t vz = 1; vz <= NUM_VZ; vz++) motor_stop(vz);
+        mux_overbudget = 0;
+    }
+
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        bit = (uint8_t) (1 << (vz - 1));
+        if (!(g_mux_zones & bit)) continue;
+
+        // position: PWM periods driven since the last pass
+        n = (uint8_t) (mux_periods[vz] - mux_counted[vz]);
+        mux_counted[vz] += n;
+        mux_ms[vz] += (uint16_t) n * PWM_PERIOD_MS;
+        tick = ms_per_tick(vz);
+        while (mux_ms[vz] >= tick)
+        {
+            mux_ms[vz] -= tick;
+            if ((g_mux_dir[vz] < 0) && (0 == g_position[vz])) g_position[vz] = 99;  // rollover
+            else g_position[vz] += g_mux_dir[vz];
+        }
+        if (!(g_mux_home & bit)) motor_position(vz);    // back EMF (if calibrated)
+        t_run = (uint16_t) (g_timer_ms - mux_tramp[vz]);
+
+        if (g_mux_home & bit)   // home run
+        {
+            if ((uint16_t) (g_timer_ms - mux_thome[vz]) >= 1000)
+            {   // count seconds
+                mux_thome[vz] += 1000;
+                if (++mux_shome[vz] > g_home_s)
+                {
+                    g_mux_home &= ~bit;     // abort
+                    motor_stop(vz);
+                    continue;
+                }
+            }
+            if (STALL_END == mux_stall(vz, t_run))  // end position reached?
+            {
+                motor_home_end(vz);         // set home position
+                g_STATUSflags.ref |= bit;   // ref set
+                g_mux_home &= ~bit;         // done
+                motor_stop(vz);
+                continue;
+            }
+            g_mux_dir[vz] = -1;     // close direction
+            n = motor_duty(t_run, 100);
+            if (n < duty) duty = n;
+            continue;
+        }
+
+        if (!(g_STATUSflags.pend & bit))    // move cancelled
+        {
+            motor_stop(vz);
+            continue;
+        }
+
+        if (STALL_END == mux_stall(vz, t_run))  // over current (solo sample)?
+        {
+            g_ERRORflags.OVER_CURR = 1;
+            g_STATUSflags.pend &= ~bit;     // abort this zone only
+            motor_stop(vz);
+            continue;
+        }
+
+        diff = (int8_t) (g_setpos[vz] - g_position[vz]);
+        if (((diff > 0) && (g_mux_dir[vz] < 0)) || ((diff < 0) && (g_mux_dir[vz] > 0)))
+        {   // reverse: stop motor first
+            g_mux_dir[vz] = 0;
+            mux_trev[vz] = g_timer_ms;
+        }
+        else if ((uint16_t) (g_timer_ms - mux_trev[vz]) < REVERSE_MS)
+        {
+            g_mux_dir[vz] = 0;      // motor stopping
+        }
+        else if (diff != 0)
+        {
+            if (0 == g_mux_dir[vz])     // start: ramp, new back EMF average
+            {
+                mux_tramp[vz] = g_timer_ms;
+                motor_stall_reset(vz);
+            }
+            g_mux_dir[vz] = (diff > 0) ? +1 : -1;
+            n = motor_duty(t_run, (uint8_t) ((diff > 0) ? diff : -diff));
+            if (n < duty) duty = n;
+        }
+        else    // position reached
+        {
+            g_STATUSflags.pend &= ~bit;
+            motor_stop(vz);
+        }
+    }
+    if (g_mux_zones) motor_pwm_duty(duty);  // (shared by all zones)
+    g_STATUSflags.vz = g_mux_zones;
+    g_STATUSflags.home = (g_mux_home != 0);
+
+    return (g_mux_zones != 0);
+
+} // motor_run ()
+
+
+/** @brief Maps the H-bridge inputs for the next PWM period. Called by
+ *  PWM1_isr() on the right edge of slice1 (H-bridges are OFF). \n
+ *  Counts the periods driven by each zone, selects the zone of the next
+ *  solo period (every MUX_PERIODS-th period, every period if only one zone
+ *  is running) and maps PWM1S1P1_OUT to the inputs of the zones to drive.
+ */
+void motor_mux_isr (void)
+{
+    uint8_t     solo = 0;
+    int8_t      dir;
+
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        if (mux_mapped[vz]) mux_periods[vz]++;  // period driven
+    }
+
+    if (0 == (g_mux_zones & (g_mux_zones - 1)))     // one zone only
+    {
+        mux_period = 0;
+        for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+        {
+            if (g_mux_zones & (1 << (vz - 1))) solo = vz;
+        }
+    }
+    else if (++mux_period >= MUX_PERIODS)   // solo period: next zone
+    {
+        mux_period = 0;
+        for (uint8_t i = 0; i < NUM_VZ; i++)
+        {
+            if (++mux_next > NUM_VZ) mux_next = 1;
+            if (g_mux_zones & (1 << (mux_next - 1)))
+            {
+                solo = mux_next;
+                break;
+            }
+        }
+    }
+
+    for (uint8_t vz = 1; vz <= NUM_VZ; vz++)
+    {
+        dir = 0;
+        if ((g_mux_zones & (1 << (vz - 1))) && ((0 == solo) || (vz == solo)))
+        {
+            dir = g_mux_dir[vz];
+        }
+        *pps_open[vz]  = (dir > 0) ? PPS_PWM1S1P1 : 0;
+        *pps_close[vz] = (dir < 0) ? PPS_PWM1S1P1 : 0;
+        mux_mapped[vz] = dir;
+    }
+    g_mux_solo = solo;
+
+} // motor_mux_isr ()
+
+
+/** @brief Takes the current sample of a PWM period (measured on the right 
+ *  edge of slice 2, motor current settled). Called by daq_process().
+ *  @param  solo:   zone running alone in this period (0: all)
+ *          mAx10:  motor current (sum of all driven zones) / 0.1 mA
+ */
+void motor_sample (uint8_t solo, int16_t mAx10)
+{
+    if (mAx10 > g_mAx10_budget)
+    {
+        if (mux_overbudget < 255) mux_overbudget++;
+    }
+    else mux_overbudget = 0;
+
+    if (solo) g_mux_mAx10[solo] = mAx10;
+
+} // motor_sample ()
+
+
+/** @brief Takes the back EMF sample of zone vz for motor_stall(). Called by
+ *  daq_process() (single zone: every period, concurrent zones: solo periods;
+ *  the current of this period has been processed before).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ *          vbemf:  back EMF (ADC raw, unfiltered)
+ */
+void motor_bemf (uint8_t vz, uint16_t vbemf)
+{
+    stall_vbemf[vz] = vbemf;
+    stall_new[vz] = true;
+
+} // motor_bemf ()
+
+
+/** @brief Returns the number of PWM periods, which zone vz has been driven
+ *  since its last back EMF sample. Called by PWM1_isr() in a solo period of
+ *  vz (or any period of the single zone), the back EMF is weighted by the 
+ *  result (all driven periods count for the integral, although only the solo
+ *  periods are measured, and periods without sample are skipped).
+ *  @param  vz:     solo zone [1 .. NUM_VZ]
+ */
+uint8_t motor_weight_isr (uint8_t vz)
+{
+    uint8_t     n = (uint8_t) (mux_periods[vz] - mux_sampled[vz]);
+
+    mux_sampled[vz] = mux_periods[vz];
+    return (n);
+
+} // motor_weight_isr ()
+
+
+/** @brief Counts a PWM period of the single zone vz (no concurrent zones, 
+ *  motor_mux_isr() counts those). Called by PWM1_isr() on the right edge of
+ *  slice 1, before motor_weight_isr().
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+void motor_period_isr (uint8_t vz)
+{
+    mux_periods[vz]++;
+
+} // motor_period_isr ()
+
+
+/** @brief Start or change of direction of the single zone vz (set_pwm()):
+ *  the periods driven before don't count for the next back EMF sample.
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+void motor_weight_reset (uint8_t vz)
+{
+    mux_sampled[vz] = mux_periods[vz];
+
+} // motor_weight_reset ()
+
+
+/** @brief Saves the start of a home run for the calibration of g_bemf_full[]
+ *  (call before the reference flag is cleared).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+void motor_home_start (uint8_t vz)
+{
+    cal_sum0[vz] = g_vbemf_sum[vz];
+    cal_pos0[vz] = (g_STATUSflags.ref & (1 << (vz - 1))) ? g_position[vz] : 0;
+    mux_sampled[vz] = mux_periods[vz];
+
+} // motor_home_start ()
+
+
+/** @brief End of a successful home run (closed end stop): calibrates
+ *  g_bemf_full[vz] and sets the home position. 
+
+ *  A home run from position p travels p %, so 100 % correspond to the 
+ *  integral of the home run x 100 / p. The first run sets g_bemf_full[vz],
+ *  further runs average it (1/4 weight); results outside 1/2 .. 2 x of the 
+ *  present value are discarded (obstructed or slipping drive).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+void motor_home_end (uint8_t vz)
+{
+    int32_t     full;
+
+    full = g_vbemf_sum[vz];
+    g_vbemf_sum[vz] = 0;            // home position
+
+    if (cal_pos0[vz] >= CAL_MIN_POS)
+    {
+        full = (cal_sum0[vz] - full) * 100 / cal_pos0[vz];
+        if (0 == g_bemf_full[vz]) 
+        {
+            if (full > 0) g_bemf_full[vz] = full;
+        }
+        else if ((full > g_bemf_full[vz] / 2) && (full < g_bemf_full[vz] * 2))
+        {
+            g_bemf_full[vz] += (full - g_bemf_full[vz]) / 4;
+        }
+    }
+    cal_pos0[vz] = 0;
+    g_position[vz] = 0;
+
+} // motor_home_end ()
+
+
+/** @brief Sets g_position[vz] from the back EMF integral: 
+ *  g_vbemf_sum[vz] x 100 / g_bemf_full[vz], limited to [0 .. 100].
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ *  @return false:  not calibrated (g_position[vz] unchanged, time based)
+ */
+bool motor_position (uint8_t vz)
+{
+    int32_t     pos;
+
+    if (g_bemf_full[vz] <= 0) return (false);
+
+    pos = g_vbemf_sum[vz];          // (updated by daq_process() only)
+    pos = (pos * 100 + g_bemf_full[vz] / 2) / g_bemf_full[vz];
+    if (pos < 0) pos = 0;
+    if (pos > 100) pos = 100;
+    g_position[vz] = (uint8_t) pos;
+
+    return (true);
+
+} // motor_position ()
+
+
+/** @brief Returns the duty of the motion profile g_profile: ramps linearly
+ *  from duty_start to g_duty_max within ramp_ms after the start and drops to
+ *  duty_slow, when the distance to the target is not more than slow_pct.
+ *  The duty never exceeds g_duty_max.
+ *  @param  t_run:  [ms] time since the start from standstill
+ *          dist:   [%] distance to the target (100: home run)
+ *  @return [%] duty [DUTY_MIN .. g_duty_max]
+ */
+uint8_t motor_duty (uint16_t t_run, uint8_t dist)
+{
+    uint8_t     duty = g_duty_max;
+
+    if ((t_run < g_profile.ramp_ms) && (g_profile.duty_start < g_duty_max))
+    {
+        duty = (uint8_t) (g_profile.duty_start + (uint32_t) (g_duty_max - g_profile.duty_start)
+                          * t_run / g_profile.ramp_ms);
+    }
+    if ((dist <= g_profile.slow_pct) && (g_profile.duty_slow < duty)) duty = g_profile.duty_slow;
+    if (duty < DUTY_MIN) duty = DUTY_MIN;
+
+    return (duty);
+
+} // motor_duty ()
+
+
+/** @brief Over current blanking during the ramp: the start-up current of the
+ *  motor is no end position, unless it exceeds twice the limit.
+ *  @param  t_run:      [ms] time since the start from standstill
+ *          mAx10:      motor current
+ *          mAx10_max:  current limit of the zone
+ *  @return true:   ignore the over current
+ */
+bool motor_ramp_blank (uint16_t t_run, int16_t mAx10, int16_t mAx10_max)
+{
+    return ((t_run < g_profile.ramp_ms) && (mAx10 <= 2 * mAx10_max));
+
+} // motor_ramp_blank ()
+
+
+/** @brief Sets the duty of PWM1 slice 1 (ON time of the H-bridges). The new
+ *  value is loaded at the end of the current period (PWM1CONbits.LD). The
+ *  current sample (PWM1S1P2) stays at 25 %.
+ *  @param  duty:   [%] duty, limited to [DUTY_MIN .. g_duty_max]
+ */
+void motor_pwm_duty (uint8_t duty)
+{
+    uint16_t    p1;
+
+    if (duty < DUTY_MIN) duty = DUTY_MIN;
+    if (duty > g_duty_max) duty = g_duty_max;
+    if (duty == g_duty) return;
+
+    p1 = (uint16_t) (((uint32_t) PWM1_PERIOD + 1) * duty / 100);
+    PWM1S1P1L = (uint8_t) p1;
+    PWM1S1P1H = (uint8_t) (p1 >> 8);
+    PWM1CONbits.LD = 1;     // load the buffered value at the end of the period
+    g_duty = duty;
+
+} // motor_pwm_duty ()
+
+
+/** @brief Resets the stall detection of zone vz (call at each start from
+ *  standstill: the back EMF average is built anew).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ */
+void motor_stall_reset (uint8_t vz)
+{
+    stall_new[vz] = false;
+    stall_avg[vz] = 0;
+    stall_nrun[vz] = 0;
+    stall_n[vz] = 0;
+
+} // motor_stall_reset ()
+
+
+/** @brief Evaluates the newest sample of zone vz (current and back EMF of
+ *  the same PWM period): 
+ *  - current below the limit: the back EMF average is updated (1/8), 
+ *  - current over the limit and back EMF below 1/4 of the average (after at
+ *    least STALL_RUN samples below the limit): end stop after STALL_PERIODS
+ *    consecutive samples,
+ *  - current over the limit, back EMF not collapsed: spike (start-up current,
+ *    heavy load or the motor has not run yet, e.g. started at the end stop).
+ *  @param  vz:         valve zone [1 .. NUM_VZ]
+ *          mAx10:      motor current of this period
+ *          mAx10_max:  current limit of the zone
+ *  @return StallStates (STALL_NONE: no new sample since the last call)
+ */
+uint8_t motor_stall (uint8_t vz, int16_t mAx10, int16_t mAx10_max)
+{
+    uint16_t    vbemf;
+
+    if (!stall_new[vz]) return (STALL_NONE);
+    stall_new[vz] = false;
+    vbemf = stall_vbemf[vz];
+
+    if (mAx10 <= mAx10_max)     // running
+    {
+        if (0 == stall_nrun[vz]) stall_avg[vz] = vbemf;
+        else stall_avg[vz] = stall_avg[vz] - (stall_avg[vz] >> 3) + (vbemf >> 3);
+        if (stall_nrun[vz] < STALL_RUN) stall_nrun[vz]++;
+        stall_n[vz] = 0;
+        return (STALL_FREE);
+    }
+
+    if ((stall_nrun[vz] >= STALL_RUN) && (vbemf < (stall_avg[vz] >> STALL_COLLAPSE)))
+    {
+        if (++stall_n[vz] >= STALL_PERIODS) return (STALL_END);
+        return (STALL_NONE);    // (wait for the next sample)
+    }
+    stall_n[vz] = 0;
+    return (STALL_SPIKE);
+
+} // motor_stall ()
+
+
+// *** private function bodies
+
+/** @brief Starts a zone (the direction is set by motor_run()). The PWM1
+ *  parameter interrupts are enabled with the first zone.
+ */
+static void motor_start (uint8_t vz)
+{
+    g_mux_dir[vz] = 0;
+    mux_counted[vz] = mux_periods[vz];
+    mux_ms[vz] = 0;
+    mux_nover[vz] = 0;
+    motor_stall_reset(vz);
+    mux_trev[vz] = g_timer_ms - REVERSE_MS;     // no stop pending
+    mux_thome[vz] = g_timer_ms;
+    mux_shome[vz] = 0;
+    mux_sampled[vz] = mux_periods[vz];
+    mux_tramp[vz] = g_timer_ms;
+
+    if (0 == g_mux_zones)
+    {
+        mux_overbudget = 0;
+        PWM1GIR = 0;            // clear PWM1 interrupts flags
+        PWM1GIEbits.S1P1IE = 1; // enable PWM1 Param1 int (right edge)
+        PWM1GIEbits.S1P2IE = 1; // enable PWM1 Param2 int (right edge)
+        PIE4bits.PWM1IE = 1;    // enable PWM1_16BIT param interrupts
+    }
+    g_mux_zones |= (uint8_t) (1 << (vz - 1));
+
+} // motor_start ()
+
+
+/** @brief Stops a zone. The PWM1 parameter interrupts are disabled with the
+ *  last zone.
+ */
+static void motor_stop (uint8_t vz)
+{
+    if (!(g_mux_zones & (1 << (vz - 1)))) return;
+
+    g_mux_dir[vz] = 0;      // (the ISR maps dir 0 from now on)
+    g_mux_zones &= (uint8_t) ~(1 << (vz - 1));
+    *pps_open[vz] = *pps_close[vz] = 0;     // inputs = 0 (NO RUN)
+    mux_mapped[vz] = 0;
+
+    if (0 == g_mux_zones)
+    {
+        PWM1GIE = 0;            // Disable parameter interrupts in PWM1
+        PIE4bits.PWM1IE = 0;    // disable PWM1_16BIT param interrupts
+        g_mux_solo = 0;
+    }
+
+} // motor_stop ()
+
+
+/** @brief Evaluates the solo samples of zone vz: end stop (motor_stall()), or 
+ *  g_mux_overcurr consecutive spikes over the limit (the start-up current is 
+ *  blanked by motor_ramp_blank()).
+ *  @param  vz:     valve zone [1 .. NUM_VZ]
+ *          t_run:  [ms] time since the start from standstill
+ *  @return STALL_END: stop the zone
+ */
+static uint8_t mux_stall (uint8_t vz, uint16_t t_run)
+{
+    uint8_t     stall = motor_stall(vz, g_mux_mAx10[vz], g_mAx10_max[vz]);
+
+    if (STALL_SPIKE == stall)
+    {
+        if (motor_ramp_blank(t_run, g_mux_mAx10[vz], g_mAx10_max[vz])) mux_nover[vz] = 0;
+        else if (++mux_nover[vz] >= g_mux_overcurr) stall = STALL_END;
+    }
+    else if (STALL_FREE == stall) mux_nover[vz] = 0;
+
+    return (stall);
+
+} // mux_stall ()
+
+/**
+ End of File
+ */
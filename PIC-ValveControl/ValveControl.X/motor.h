@@ -0,0 +1,88 @@
+/**
+ *  @file motor.h
+ *  @brief Declarations for module motor.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ *  - Concurrent home runs (g_mux_home)
+ *  - Position estimator from the back EMF integral (g_bemf_full)
+ *  - Motion profiles: duty ramp at start, slowdown before the target (g_profile)
+ *  - Stall detection from current and back EMF (motor_stall())
+ *  - motor_sample() and motor_bemf() called by daq_process() (main loop)
+ *  - MUX_OVERCURR, DUTY_MAX: defaults of g_mux_overcurr, g_duty_max (param.c)
+ *  - motor_period_isr(), motor_weight_reset(): back EMF weight of the single zone
+ */
+#ifndef _MOTOR_H
+#define	_MOTOR_H
+
+// data type, constant and macro definitions
+
+#define PWM_PERIOD_MS   8       /* [ms] period of PWM1 (125 Hz, see init_pwm1_16bit()) */
+#define MUX_PERIODS     4       /* every MUX_PERIODS-th PWM period one zone runs alone */
+#define MUX_OVERCURR    2       /* default consecutive solo samples over the limit: over current (g_mux_overcurr) */
+#define MUX_OVERBUDGET  12      /* consecutive samples over the budget: stop all zones */
+#define BUDGET_mAx10    600     /* default total current budget / 0.1 mA (Budget:) */
+#define CAL_MIN_POS     50      /* [%] min. start position of a home run to calibrate g_bemf_full */
+
+#define PWM1_PERIOD     0x7CFF  /* PWM1 period register (8 ms @ 4 MHz, see init_pwm1_16bit()) */
+#define DUTY_MIN        35      /* [%] min. duty: ON beyond the current sample (2 ms) + INA219 conversion */
+#define DUTY_MAX        90      /* [%] max. duty: 0.8 ms OFF to read the back EMF (limit of g_duty_max) */
+
+#define STALL_PERIODS   2       /* consecutive samples over the limit with collapsed back EMF: end stop */
+#define STALL_RUN       4       /* samples below the limit until the back EMF average is trusted */
+#define STALL_COLLAPSE  2       /* back EMF < average >> STALL_COLLAPSE: collapsed */
+
+/// Results of motor_stall()
+enum StallStates {
+    STALL_NONE = 0,     //!< no new sample since the last call
+    STALL_FREE,         //!< current below the limit (running)
+    STALL_SPIKE,        //!< current over the limit, back EMF present (start-up, heavy load)
+    STALL_END,          //!< current over the limit, back EMF collapsed (end stop)
+};
+
+/// Motion profile, set by "Profile:" or "Param:" (see motor_duty())
+typedef struct {
+    uint8_t     duty_start;     //!< [%] duty at start (ramp to g_duty_max)
+    uint8_t     duty_slow;      //!< [%] duty near the target
+    uint16_t    ramp_ms;        //!< [ms] duration of the ramp (over current blanked)
+    uint8_t     slow_pct;       //!< [%] distance to the target to slow down
+} PROFILE_t;
+
+// global variables
+extern volatile uint8_t    g_mux_zones;               // zones running concurrently
+extern volatile uint8_t    g_mux_home;                // zones to home (pending or running)
+extern volatile int8_t     g_mux_dir[NUM_VZ + 1];     // direction per zone
+extern volatile int16_t    g_mux_mAx10[NUM_VZ + 1];   // motor current per zone (solo period)
+extern volatile uint8_t    g_mux_solo;                // zone running alone (0: all)
+extern int16_t             g_mAx10_budget;            // total current budget
+extern uint8_t             g_concurrent;              // max. number of zones at once
+extern int32_t             g_bemf_full[NUM_VZ + 1];   // back EMF integral of 100 % travel (0: none)
+extern PROFILE_t           g_profile;                 // motion profile
+extern uint8_t             g_duty;                    // [%] duty of PWM1 slice 1 (H-bridges)
+extern uint8_t             g_duty_max;                // [%] max. duty (motion profile)
+extern uint8_t             g_mux_overcurr;            // solo samples over the limit: over current
+
+// function prototypes
+extern void     motor_admit (void);
+extern bool     motor_run (void);
+extern void     motor_mux_isr (void);
+extern void     motor_sample (uint8_t solo, int16_t mAx10);
+extern void     motor_bemf (uint8_t vz, uint16_t vbemf);
+extern uint8_t  motor_weight_isr (uint8_t vz);
+extern void     motor_period_isr (uint8_t vz);
+extern void     motor_weight_reset (uint8_t vz);
+extern void     motor_home_start (uint8_t vz);
+extern void     motor_home_end (uint8_t vz);
+extern bool     motor_position (uint8_t vz);
+extern uint8_t  motor_duty (uint16_t t_run, uint8_t dist);
+extern bool     motor_ramp_blank (uint16_t t_run, int16_t mAx10, int16_t mAx10_max);
+extern void     motor_pwm_duty (uint8_t duty);
+extern void     motor_stall_reset (uint8_t vz);
+extern uint8_t  motor_stall (uint8_t vz, int16_t mAx10, int16_t mAx10_max);
+
+#endif	/* _MOTOR_H */
+
@@ -0,0 +1,89 @@
+/**
+ * @file param.c
+ *  @brief  Parameter table: motion parameters tunable at runtime
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  The parameters used to be compile time constants (MSperTICK, TIMEOUThome,
+ *  the over current counts, DUTY_MAX, ...), which now are the defaults of
+ *  the variables in param_table[]. "Param?" reads, "Param:ix,value" sets a
+ *  parameter (see ParamIds). param_set() checks the range of the table,
+ *  values out of range are rejected (E_PARAM_RANGE).
+ *  The values are kept in the EEPROM by journal_poll() (single record,
+ *  written when a value has changed, restored by journal_restore()).
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ */
+
+#include <xc.h>             /* XC8 General Include File */
+#include "main.h"
+#include "daq.h"
+#include "motor.h"
+#include "param.h"
+
+// *** data type, constant and macro definitions
+
+/// Entry of the parameter table
+typedef struct {
+    void        *var;       //!< variable
+    uint8_t     size;       //!< sizeof(variable): 1 or 2 bytes
+    uint16_t    min;        //!< lower limit
+    uint16_t    max;        //!< upper limit
+} PARAM_t;
+
+// *** global variables
+
+// *** private variables
+/// Parameter table (index: ParamIds)
+static const PARAM_t    param_table[NUM_PARAM] = {
+    { &g_tick_ms,               2,  10,         1000 },
+    { &g_home_s,                1,  10,         250 },
+    { &g_overcurr_n,            1,  1,          100 },
+    { &g_mux_overcurr,          1,  1,          20 },
+    { &g_duty_max,              1,  DUTY_MIN,   DUTY_MAX },
+    { &g_profile.duty_start,    1,  DUTY_MIN,   DUTY_MAX },
+    { &g_profile.duty_slow,     1,  DUTY_MIN,   DUTY_MAX },
+    { &g_profile.ramp_ms,       2,  0,          5000 },
+    { &g_profile.slow_pct,      1,  0,          100 },
+    { &g_log_div,               1,  1,          16 },
+};
+
+// *** private function prototypes
+
+// *** public function bodies
+
+/** @brief Returns the value of a parameter.
+ *  @param  ix:     ParamIds
+ *  @return value (0: ix out of range)
+ */
+uint16_t param_get (uint8_t ix)
+{
+    if (ix >= NUM_PARAM) return (0);
+    if (1 == param_table[ix].size) return (*(uint8_t *) param_table[ix].var);
+    return (*(uint16_t *) param_table[ix].var);
+
+} // param_get ()
+
+
+/** @brief Sets a parameter, if the value is within its range.
+ *  @param  ix:     ParamIds
+ *          value:  new value
+ *  @return 0 or E_PARAM_RANGE
+ */
+int8_t param_set (uint8_t ix, int32_t value)
+{
+    if (ix >= NUM_PARAM) return (E_PARAM_RANGE);
+    if ((value < param_table[ix].min) || (value > param_table[ix].max)) return (E_PARAM_RANGE);
+
+    if (1 == param_table[ix].size) *(uint8_t *) param_table[ix].var = (uint8_t) value;
+    else *(uint16_t *) param_table[ix].var = (uint16_t) value;
+    return (0);
+
+} // param_set ()
+
+/**
+ End of File
+ */
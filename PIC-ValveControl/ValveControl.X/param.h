@@ -0,0 +1,48 @@
+/**
+ *  @file param.h
+ *  @brief Declarations for module param.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ */
+#ifndef _PARAM_H
+#define	_PARAM_H
+
+// data type, constant and macro definitions
+
+#define PARAM_VERSION   1       /* layout of PARAMREC_t (records of other versions are ignored) */
+
+/// Index of the parameters ("Param:ix,value", same order on the ESP)
+enum ParamIds {
+    PARAM_TICK_MS = 0,  //!< [ms] time per 1 % travel of uncalibrated zones (g_tick_ms)
+    PARAM_HOME_S,       //!< [s] timeout of home and calibration runs (g_home_s)
+    PARAM_OVERCURR,     //!< over current samples to stop a single zone move (g_overcurr_n)
+    PARAM_MUX_OVERCURR, //!< solo samples over the limit to stop a concurrent zone (g_mux_overcurr)
+    PARAM_DUTY_MAX,     //!< [%] max. duty of the H-bridges (g_duty_max)
+    PARAM_DUTY_START,   //!< [%] duty at start (g_profile.duty_start)
+    PARAM_DUTY_SLOW,    //!< [%] duty near the target (g_profile.duty_slow)
+    PARAM_RAMP_MS,      //!< [ms] duration of the ramp (g_profile.ramp_ms)
+    PARAM_SLOW_PCT,     //!< [%] distance to the target to slow down (g_profile.slow_pct)
+    PARAM_LOG_DIV,      //!< data logger: every n-th sample (g_log_div)
+    NUM_PARAM
+};
+
+/// Parameter record (23 bytes, EEPROM, see journal.c)
+typedef struct {
+    uint8_t     version;                //!< PARAM_VERSION
+    uint16_t    value[NUM_PARAM];       //!< param_get(0 .. NUM_PARAM - 1)
+    uint16_t    crc;                    //!< CRC-16/CCITT of the bytes above
+} PARAMREC_t;
+
+// global variables
+
+// function prototypes
+extern uint16_t param_get (uint8_t ix);
+extern int8_t   param_set (uint8_t ix, int32_t value);
+
+#endif	/* _PARAM_H */
+
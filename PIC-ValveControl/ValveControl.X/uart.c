@@ -0,0 +1,326 @@
+/**
+ * @file uart.c
+ *  @brief  UART1 serviced by DMA: RX and TX ring buffers
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  Neither receiving nor sending blocks the main loop:
+ *  - RX: DMA2 copies every received char (trigger U1RX) into rx_ring[]. The
+ *    destination wraps at UART_RX_SIZE (circular, never stops). uart_poll()
+ *    assembles the chars behind the DMA write position into g_rx232_buf[]
+ *    and sets g_rs232_request on CR/LF (ASCII command) or when a binary frame
+ *    (1st byte FRAME_SYNC) is complete after LEN + 5 bytes.
+ *  - TX: putch() (and uart_puts()) appends to tx_ring[] and returns. DMA1 sends
+ *    the contiguous part between tail and head (trigger U1TX), its source
+ *    count interrupt (uart_tx_isr()) starts the next part.
+ *  There is no interrupt per char any more, so the UART can run at higher
+ *  baud rates without overrun, while the main loop is busy.
+ *
+ *  Baud rate negotiation ("Baud:<rate>", see uart_baud()): the response is
+ *  sent at the current rate, then uart_poll() switches to the new rate. The
+ *  ESP has to confirm by the same command at the new rate within 
+ *  UART_VERIFY_MS, else the PIC falls back to UART_BAUD_DEFAULT. The 
+ *  bootloader supports the same handshake.
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue (replaces U1RX_isr() and the blocking putch())
+ * - Baud rate negotiation (uart_baud())
+ * - Added uart_puts() (responses are no longer sent by printf())
+ */
+
+#include <xc.h>             /* XC8 General Include File */
+#include "main.h"
+#include "frame.h"
+#include "uart.h"
+
+// *** data type, constant and macro definitions
+#define DMA_TX          0       /* DMASELECT of the TX channel (DMA1) */
+#define DMA_RX          1       /* DMASELECT of the RX channel (DMA2) */
+#define NUM_BAUD        4       /* number of supported baud rates */
+
+// *** global variables
+
+// *** private variables
+static volatile uint8_t rx_ring[UART_RX_SIZE];  ///< written by DMA2
+static uint8_t          rx_tail;                ///< next char to assemble
+static volatile uint8_t tx_ring[UART_TX_SIZE];  ///< read by DMA1
+static volatile uint8_t tx_head;                ///< next free position (putch())
+static volatile uint8_t tx_tail;                ///< first char not yet sent
+static volatile uint8_t tx_len;                 ///< chars in transfer by DMA1 (0: idle)
+
+/// Supported baud rates (@16 MHz, BRGS = 1: Baud = 4e6 / (BRG + 1), error < 1 %)
+static const uint32_t   baud_rate[NUM_BAUD] = { UART_BAUD_DEFAULT, 115200, 250000, 500000 };
+static const uint8_t    baud_brg[NUM_BAUD]  = { 103,               34,     15,     7 };
+static uint8_t          baud_ix;                ///< current baud rate (index of baud_rate[])
+static uint8_t          baud_next;              ///< requested baud rate (switched by uart_poll())
+static bool             baud_verify;            ///< new baud rate not yet confirmed
+static uint16_t         baud_tstart;            ///< g_timer_ms of the switch
+
+// *** private function prototypes
+static void     uart_rx_char (uint8_t ch);
+static void     uart_tx_start (void);
+static void     uart_baud_set (uint8_t ix);
+
+// *** public function bodies
+
+/** @brief Configures DMA1 (TX) and DMA2 (RX) for UART1 (see init_uart1()).
+ *  The interrupt flags of U1RX / U1TX trigger the DMA, their interrupts stay
+ *  disabled.
+ */
+void uart_init (void)
+{
+    PIE4bits.U1RXIE = 0;        // chars are taken by DMA2
+    PIE4bits.U1TXIE = 0;
+    rx_tail = 0;
+    tx_head = tx_tail = tx_len = 0;
+    uart_baud_set(0);           // (same rate as init_uart1())
+    baud_verify = false;
+
+    // DMA2: U1RXB -> rx_ring[] (circular)
+    DMASELECT = DMA_RX;
+    DMAnCON0 = 0;               // disable channel during setup
+    DMAnCON1 = 0x40;            // DMODE increment, DSTP no stop, SMR SFR/GPR, SMODE fixed, SSTP no stop
+    DMAnSSA = (uint24_t) &U1RXB;
+    DMAnSSZ = 1;
+    DMAnDSA = (uint16_t) rx_ring;
+    DMAnDSZ = UART_RX_SIZE;
+    DMAnSIRQ = IRQ_U1RX;        // start trigger: char received
+    DMAnAIRQ = 0;               // no abort trigger
+    DMAnCON0bits.SIRQEN = 1;
+    DMAnCON0bits.EN = 1;
+
+    // DMA1: tx_ring[] -> U1TXB (started by uart_tx_start())
+    DMASELECT = DMA_TX;
+    DMAnCON0 = 0;
+    DMAnCON1 = 0x03;            // DMODE fixed, DSTP no stop, SMR SFR/GPR, SMODE increment, SSTP stop at SCNT 0
+    DMAnDSA = (uint16_t) &U1TXB;
+    DMAnDSZ = 1;
+    DMAnSIRQ = IRQ_U1TX;        // start trigger: TX buffer empty
+    DMAnAIRQ = 0;
+    PIR2bits.DMA1SCNTIF = 0;
+    PIE2bits.DMA1SCNTIE = 1;    // part sent: uart_tx_isr()
+    DMAnCON0bits.EN = 1;
+
+} // uart_init ()
+
+
+/** @brief Assembles the chars received by DMA2 into g_rx232_buf[]. Call from
+ *  the main loop. Does nothing while a command is pending (g_rs232_request),
+ *  the chars remain in rx_ring[] until cmd_interpreter() has finished. \n
+ *  Switches the baud rate requested by uart_baud(), as soon as the response
+ *  has been sent, and falls back to UART_BAUD_DEFAULT, if the new rate is not
+ *  confirmed within UART_VERIFY_MS. Chars received with errors at a higher 
+ *  rate let it fall back as well, so the ESP can always resynchronize.
+ */
+void uart_poll (void)
+{
+    uint8_t     head;
+
+    if ((baud_next != baud_ix) && uart_tx_idle())
+    {   // response sent at the current rate: switch
+        uart_baud_set(baud_next);
+        baud_verify = (baud_ix != 0);
+        baud_tstart = g_timer_ms;
+    }
+    if (baud_verify && ((uint16_t) (g_timer_ms - baud_tstart) >= UART_VERIFY_MS))
+    {   // not confirmed: the ESP has not followed
+        uart_baud_set(0);
+        baud_verify = false;
+    }
+
+    if (U1ERRIRbits.RXFOIF || U1ERRIRbits.FERIF)
+    {   // overrun or framing error: drop the partial line
+        U1ERRIRbits.RXFOIF = U1ERRIRbits.FERIF = 0;
+        for (uint8_t i = 0; i < sizeof(g_rx232_buf); i++) g_rx232_buf[i] = 0;
+        g_rx232_count = 0;
+        if (baud_ix != 0)
+        {   // wrong baud rate (p.e. ESP restarted at UART_BAUD_DEFAULT)
+            uart_baud_set(0);
+            baud_verify = false;
+        }
+    }
+
+    interrupt_GlobalHighDisable();  // (DMASELECT shared with uart_tx_isr())
+    DMASELECT = DMA_RX;
+    head = (uint8_t) (UART_RX_SIZE - DMAnDCNT);     // DMA write position
+    interrupt_GlobalHighEnable();
+    head &= (UART_RX_SIZE - 1);
+
+    while ((rx_tail != head) && !g_rs232_request)
+    {
+        uart_rx_char(rx_ring[rx_tail]);
+        rx_tail = (rx_tail + 1) & (UART_RX_SIZE - 1);
+    }
+
+} // uart_poll ()
+
+
+/** @brief Appends one char to the TX ring, DMA1 sends it. This is also the
+ *  helper function for the printf() function. \n
+ *  Waits only if the ring is full: when no space gets free within approx.
+ *  1 ms, the function returns and data gets lost.
+ */
+void putch (char data)
+{
+    uint8_t     next = (tx_head + 1) & (UART_TX_SIZE - 1);
+    bool        gieh = INTCON0bits.GIEH;
+
+    for (uint8_t timeout = 20; (next == tx_tail) && (timeout > 0); --timeout)
+    {
+        __delay_us(50);
+    }
+    if (next == tx_tail) return;    // ring full
+
+    tx_ring[tx_head] = (uint8_t) data;
+    interrupt_GlobalHighDisable();
+    tx_head = next;
+    if (0 == tx_len) uart_tx_start();   // DMA1 idle
+    if (gieh) interrupt_GlobalHighEnable();
+
+} // putch
+
+
+/** @brief Appends a string to the TX ring (see putch()).
+ */
+void uart_puts (const char *s)
+{
+    while (*s) putch(*s++);
+
+} // uart_puts ()
+
+
+/** @brief Returns the free space of the TX ring (see "LogData?").
+ */
+uint8_t uart_tx_free (void)
+{
+    return ((uint8_t) ((tx_tail - tx_head - 1) & (UART_TX_SIZE - 1)));
+
+} // uart_tx_free ()
+
+
+/** @brief Returns true, when all chars have been sent (TX ring empty and
+ *  shift register empty), p.e. before a reset.
+ */
+bool uart_tx_idle (void)
+{
+    return ((tx_head == tx_tail) && U1ERRIRbits.TXMTIF);
+
+} // uart_tx_idle ()
+
+
+/** @brief DMA1 has sent its part of the TX ring: starts the next part.
+ *  Call from the DMA1 source count interrupt.
+ */
+void uart_tx_isr (void)
+{
+    PIR2bits.DMA1SCNTIF = 0;
+    tx_tail = (tx_tail + tx_len) & (UART_TX_SIZE - 1);
+    tx_len = 0;
+    uart_tx_start();
+
+} // uart_tx_isr ()
+
+
+/** @brief Requests a new baud rate (command "Baud:<rate>"). The rate is 
+ *  switched by uart_poll(), after the response has been sent. The same 
+ *  request at the new rate confirms it.
+ *  @param  baud:   [Bd] 38400, 115200, 250000 or 500000
+ *  @return 0 or E_BAUD (rate not supported)
+ */
+int8_t uart_baud (uint32_t baud)
+{
+    for (uint8_t i = 0; i < NUM_BAUD; i++)
+    {
+        if (baud != baud_rate[i]) continue;
+        if (i == baud_ix) baud_verify = false;  // confirmed (or no change)
+        else baud_next = i;
+        return (0);
+    }
+    return (E_BAUD);
+
+} // uart_baud ()
+
+
+/** @brief Returns the current baud rate [Bd] ("Baud?").
+ */
+uint32_t uart_baud_rate (void)
+{
+    return (baud_rate[baud_ix]);
+
+} // uart_baud_rate ()
+
+
+// *** private function bodies
+
+/** @brief Sets the baud rate baud_rate[ix]. Call when the shift register is
+ *  empty (uart_tx_idle()).
+ */
+static void uart_baud_set (uint8_t ix)
+{
+    U1CON0bits.BRGS = 1;        // high speed: Baud = Fosc / (4 * (BRG + 1))
+    U1BRG = baud_brg[ix];
+    baud_ix = baud_next = ix;
+
+} // uart_baud_set ()
+
+
+/** @brief Lets DMA1 send the contiguous chars from tx_tail (up to tx_head or
+ *  the end of the ring). Call with interrupts disabled or from the ISR.
+ */
+static void uart_tx_start (void)
+{
+    uint8_t     head = tx_head;
+
+    if (head == tx_tail) return;    // nothing to send
+
+    tx_len = (head > tx_tail) ? (uint8_t) (head - tx_tail) : (uint8_t) (UART_TX_SIZE - tx_tail);
+    DMASELECT = DMA_TX;
+    DMAnSSA = (uint24_t) &tx_ring[tx_tail];
+    DMAnSSZ = tx_len;
+    DMAnCON0bits.SIRQEN = 1;    // start on U1TXIF (set while TX buffer empty)
+
+} // uart_tx_start ()
+
+
+/** @brief Assembles one received char (formerly U1RX_isr()):
+ *  - Stores chars in g_rx232_buf[]
+ *  - Sets flag g_rs232_request = 1 after detection of CR or LF.
+ *  - Binary frames (1st byte FRAME_SYNC) are complete after LEN + 5 bytes.
+ */
+static void uart_rx_char (uint8_t ch)
+{
+    if ((g_rx232_count > 0) && (FRAME_SYNC == g_rx232_buf[0]))
+    {   // binary frame: no EOL, frame length is given by LEN (3rd byte)
+        g_rx232_buf[g_rx232_count++] = ch;
+        if ((g_rx232_count >= 3) && ((g_rx232_buf[2] > FRAME_MAXDATA) ||
+            (g_rx232_count >= g_rx232_buf[2] + FRAME_OVERHEAD)))
+        {   // frame complete (or invalid length: rejected by frame_interpreter)
+            g_rs232_request = 1;    // until frame has been processed
+        }
+        return;
+    } // binary frame
+
+    if (ch == '\r' || ch == '\n')
+    {
+        if (g_rx232_count <= 1) return;     // ignore leading CRLF
+        ch = 0;
+        g_rs232_request = 1;    // until cmd has been processed
+    } // EOL received
+
+    if (g_rx232_count < sizeof(g_rx232_buf))
+    {
+        g_rx232_buf[g_rx232_count++] = ch;    // save to buffer
+    }
+    else    // buffer overflow, flush RS232 buf
+    {
+        for (uint8_t i = 0; i < sizeof(g_rx232_buf); i++) g_rx232_buf[i] = 0;
+        g_rx232_count = 0;
+    }
+
+} // uart_rx_char ()
+
+/**
+ End of File
+ */
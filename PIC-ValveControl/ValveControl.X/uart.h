@@ -0,0 +1,38 @@
+/**
+ *  @file uart.h
+ *  @brief Declarations for module uart.c (project "ValveControl")
+ *  @par    (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ */
+/*  Change Log:
+ *  2026-10-16 v0.9
+ *  - First issue
+ *  - Baud rate negotiation (uart_baud())
+ *  - Added uart_puts()
+ */
+#ifndef _UART_H
+#define	_UART_H
+
+// data type, constant and macro definitions
+
+#define UART_RX_SIZE    64      /* RX ring (DMA2), power of 2 */
+#define UART_TX_SIZE    128     /* TX ring (DMA1), power of 2 */
+#define UART_BAUD_DEFAULT 38400 /* [Bd] after reset (also bootloader) */
+#define UART_VERIFY_MS  500     /* [ms] a new baud rate must be confirmed within */
+
+// global variables
+
+// function prototypes
+extern void     putch (char data);
+extern void     uart_puts (const char *s);
+extern void     uart_init (void);
+extern void     uart_poll (void);
+extern uint8_t  uart_tx_free (void);
+extern bool     uart_tx_idle (void);
+extern void     uart_tx_isr (void);
+extern int8_t   uart_baud (uint32_t baud);
+extern uint32_t uart_baud_rate (void);
+
+#endif	/* _UART_H */
+
@@ -0,0 +1,308 @@
+/**
+ * @file bench.c
+ *  @brief  Host benchmark of the command path of cmd_interpreter()
+ *  @par  (c) 2026 Klaus Deutschkämer
+ *  License: EUROPEAN UNION PUBLIC LICENCE v. 1.2 \n
+ *  see https://joinup.ec.europa.eu/collection/eupl/eupl-text-eupl-12
+ *
+ *  Compares the command path up to v0.9 (strstr() chain, sscanf(), sprintf())
+ *  with the token table and fmt.c (v0.9) for a mix of frequent commands:
+ *  lookup of the command, parsing of the parameters, formatting of the
+ *  response. Both paths must produce identical responses (checked first).
+ *  The handlers mirror those of main.c on sample data, only the commands of
+ *  the mix are implemented, the token lists are the same as in main.c.
+ *  Results are host cycles (TSC) per command, or ns on non-x86 hosts. On the
+ *  PIC (no divide instruction, doprnt interpreting the format string) the
+ *  gap is larger, the ratio shows the trend.
+ *
+ *  Build and run: make run
+ */
+/*  ChangeLog:
+ * 2026-10-16 v0.9
+ * - Initial issue
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICK_UNIT   "cycles"
+#else
+#define TICK_UNIT   "ns"
+#endif
+#include "fmt.h"
+
+// *** data type, constant and macro definitions
+#define NUM_VZ      4
+#define E_UNDEF_CMD (-4)
+#define E_VZ_RANGE  (-1)
+#define RUNS        200000      /* passes over the command mix */
+
+typedef int (*handler_t) (const char *arg, char *out);
+
+typedef struct {
+    const char  *token;
+    handler_t   handler;
+} CMD_t;
+
+// *** private variables: sample data (as main.c)
+static uint8_t      position[NUM_VZ + 1] = { 0, 35, 100, 0, 62 };
+static int16_t      mAx10 = 287;
+static uint16_t     status = 0x2115;
+static int32_t      vbemf_sum = 0x0003A2F1;
+static uint8_t      jobq_count = 2;
+static uint16_t     ms_tick[NUM_VZ + 1] = { 0, 86, 86, 90, 88 };
+static int16_t      mAx10_max[NUM_VZ + 1] = { 0, 300, 300, 350, 300 };
+static int32_t      bemf_full[NUM_VZ + 1] = { 0, 812000, 0, 790500, 1024 };
+
+/// Command mix (as sent by the ESP: status polls dominate)
+static const char * const mix[] = {
+    "Status?", "Status?", "Status?", "Move:2,50,300", "Tick:2,86,330",
+    "Bemf?", "max_mA?", "Status?",
+};
+#define NUM_MIX     (sizeof(mix) / sizeof(mix[0]))
+
+/// strstr() chain of cmd_interpreter() up to v0.9 (same order)
+static const char * const old_tokens[] = {
+    "Status?", "Move:", "Home:", "HomeAll:", "Version?", "Frame?", "Budget:",
+    "Budget?", "Bemf:", "Bemf", "Calib:", "Calib?", "Tick:", "Tick", "Profile:",
+    "Profile", "Param:", "Param", "Baud:", "Baud?", "SetPos?", "max_mA?", "LogData?",
+    "Bootload!",
+};
+enum { O_STATUS = 0, O_MOVE = 1, O_BEMF_Q = 9, O_TICK = 12, O_TICK_Q = 13, O_MAX_MA = 21 };
+
+// *** private function prototypes
+static int  new_status (const char *arg, char *out);
+static int  new_move (const char *arg, char *out);
+static int  new_tick (const char *arg, char *out);
+static int  new_bemf (const char *arg, char *out);
+static int  new_max_mA (const char *arg, char *out);
+static int  new_none (const char *arg, char *out);
+
+/// Token table of cmd_interpreter() v0.9 (same order as main.c)
+static const CMD_t  cmd_table[] = {
+    { "Status?", new_status },  { "Move:", new_move },      { "Home:", new_none },
+    { "HomeAll:", new_none },   { "Version?", new_none },   { "Frame?", new_none },
+    { "Budget:", new_none },    { "Budget?", new_none },    { "Bemf:", new_bemf },
+    { "Bemf?", new_bemf },      { "Calib:", new_none },     { "Calib?", new_none },
+    { "Tick:", new_tick },      { "Tick?", new_tick },      { "Profile:", new_none },
+    { "Profile?", new_none },   { "Param:", new_none },     { "Param?", new_none },
+    { "Baud:", new_none },      { "Baud?", new_none },      { "SetPos?", new_none },
+    { "max_mA?", new_max_mA },  { "LogData?", new_none },   { "Bootload!", new_none },
+};
+
+// *** old command path (strstr, sscanf, sprintf)
+
+static void old_cmd (const char *rx, char *tx)
+{
+    const char  *p = NULL;
+    unsigned    vz, pos, ms, vdd = 0;
+    int         mA;
+    size_t      i;
+
+    for (i = 0; i < sizeof(old_tokens) / sizeof(old_tokens[0]); i++)
+    {
+        if ((p = strstr(rx, old_tokens[i])) != NULL) break;
+    }
+    switch (i)
+    {
+        case O_STATUS:
+            sprintf(tx, "Status:%u,%u,%u,%u,%d,0x%04X,0x%08lX,%u\n",
+                position[1], position[2], position[3], position[4],
+                mAx10, status, (unsigned long) (uint32_t) vbemf_sum, jobq_count);
+            return;
+
+        case O_MOVE:
+            if (sscanf(p + 5, "%u,%u,%d\n", &vz, &pos, &mA) != 3) break;
+            sprintf(tx, "Move:%u,%u,%d\n", vz, pos, mA);
+            return;
+
+        case O_TICK:
+            if (sscanf(p + 5, "%u,%u,%u\n", &vz, &ms, &vdd) < 2) break;
+            if ((0 == vz) || (vz > NUM_VZ)) { sprintf(tx, "ERROR %d\n", E_VZ_RANGE); return; }
+            ms_tick[vz] = (uint16_t) ms;
+            /* FALLTHROUGH */
+        case O_TICK_Q:
+            sprintf(tx, "Tick:%u,%u,%u,%u\n", ms_tick[1], ms_tick[2], ms_tick[3], ms_tick[4]);
+            return;
+
+        case O_BEMF_Q:
+            sprintf(tx, "Bemf:%ld,%ld,%ld,%ld\n", (long) bemf_full[1], (long) bemf_full[2],
+                (long) bemf_full[3], (long) bemf_full[4]);
+            return;
+
+        case O_MAX_MA:
+            sprintf(tx, "max_mA:%d,%d,%d,%d\n",
+                mAx10_max[1], mAx10_max[2], mAx10_max[3], mAx10_max[4]);
+            return;
+
+        default:
+            break;
+    }
+    sprintf(tx, "ERROR %d\n", E_UNDEF_CMD);
+
+} // old_cmd ()
+
+// *** new command path (token table, fmt.c)
+
+static void new_cmd (const char *p, char *out)
+{
+    uint8_t     len;
+    int         error = E_UNDEF_CMD;
+
+    while (*p && ((*p < 'A') || (*p > 'z'))) p++;
+    for (len = 0; p[len] && (p[len] != ':') && (p[len] != '?') && (p[len] != '!'); len++) ;
+    if (p[len]) len++;
+
+    for (uint8_t i = 0; i < sizeof(cmd_table) / sizeof(cmd_table[0]); i++)
+    {
+        if (strncmp(cmd_table[i].token, p, len) || cmd_table[i].token[len]) continue;
+        error = cmd_table[i].handler(p + len, out);
+        break;
+    }
+    if (error) fmt_dec(fmt_str(out, "ERROR "), error, '\n');
+
+} // new_cmd ()
+
+
+static int new_status (const char *arg, char *out)
+{
+    out = fmt_str(out, "Status:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++) out = fmt_dec(out, position[i], ',');
+    out = fmt_dec(out, mAx10, ',');
+    out = fmt_hex(fmt_str(out, "0x"), status, 4, ',');
+    out = fmt_hex(fmt_str(out, "0x"), (uint32_t) vbemf_sum, 8, ',');
+    fmt_dec(out, jobq_count, '\n');
+    return (0);
+
+} // new_status ()
+
+
+static int new_move (const char *arg, char *out)
+{
+    int32_t     v[3];
+
+    if (fmt_parse(arg, v, 3) != 3) return (E_UNDEF_CMD);
+    out = fmt_dec(fmt_str(out, "Move:"), v[0], ',');
+    fmt_dec(fmt_dec(out, v[1], ','), v[2], '\n');
+    return (0);
+
+} // new_move ()
+
+
+static int new_tick (const char *arg, char *out)
+{
+    int32_t     v[3] = { 0, 0, 0 };
+
+    if (':' == arg[-1])
+    {
+        if (fmt_parse(arg, v, 3) < 2) return (E_UNDEF_CMD);
+        if ((v[0] <= 0) || (v[0] > NUM_VZ)) return (E_VZ_RANGE);
+        ms_tick[v[0]] = (uint16_t) v[1];
+    }
+    out = fmt_str(out, "Tick:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++) out = fmt_dec(out, ms_tick[i], (i < NUM_VZ) ? ',' : '\n');
+    return (0);
+
+} // new_tick ()
+
+
+static int new_bemf (const char *arg, char *out)
+{
+    out = fmt_str(out, "Bemf:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++) out = fmt_dec(out, bemf_full[i], (i < NUM_VZ) ? ',' : '\n');
+    return (0);
+
+} // new_bemf ()
+
+
+static int new_max_mA (const char *arg, char *out)
+{
+    out = fmt_str(out, "max_mA:");
+    for (uint8_t i = 1; i <= NUM_VZ; i++) out = fmt_dec(out, mAx10_max[i], (i < NUM_VZ) ? ',' : '\n');
+    return (0);
+
+} // new_max_mA ()
+
+
+static int new_none (const char *arg, char *out)
+{
+    return (E_UNDEF_CMD);
+
+} // new_none ()
+
+// *** measurement
+
+static uint64_t ticks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (__rdtsc());
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec);
+#endif
+}
+
+
+static double measure (void (*cmd) (const char *, char *))
+{
+    char                tx[64];
+    volatile char       sink = 0;
+    uint64_t            t0 = ticks();
+
+    for (long r = 0; r < RUNS; r++)
+    {
+        for (size_t i = 0; i < NUM_MIX; i++)
+        {
+            cmd(mix[i], tx);
+            sink ^= tx[7];      // (keep the result alive)
+        }
+    }
+    (void) sink;
+    return ((double) (ticks() - t0) / ((double) RUNS * NUM_MIX));
+}
+
+
+int main (void)
+{
+    char        a[64], b[64];
+    double      t_old, t_new;
+    int         errors = 0;
+
+    // the responses must be identical (also for a few edge cases)
+    static const char * const check[] = {
+        "Status?", "Move:2,50,300", "Move:2,50", "Tick:2,86,330", "Tick:9,86",
+        "Tick?", "Bemf?", "max_mA?", "Version?x", "Bogus:1",
+    };
+    for (size_t i = 0; i < sizeof(check) / sizeof(check[0]); i++)
+    {
+        old_cmd(check[i], a);
+        new_cmd(check[i], b);
+        if (strcmp(a, b))
+        {
+            printf("MISMATCH %-16s old: %s         new: %s", check[i], a, b);
+            errors++;
+        }
+    }
+
+    t_old = measure(old_cmd);
+    t_new = measure(new_cmd);
+
+    printf("command mix of %u commands, %d runs\n", (unsigned) NUM_MIX, RUNS);
+    printf("strstr / sscanf / sprintf: %8.1f %s per command\n", t_old, TICK_UNIT);
+    printf("token table / fmt.c:       %8.1f %s per command\n", t_new, TICK_UNIT);
+    printf("speedup:                   %8.1f x\n", t_old / t_new);
+
+    return (errors ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/**
+ End of File
+ */